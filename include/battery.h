@@ -0,0 +1,125 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "config.h"
+#include "led_ring.h"
+
+// ----------------------------
+// Battery monitor
+// ----------------------------
+// Vcc from one ADC conversion of the internal 1.1V bandgap against AVcc:
+// Vcc = bandgap * 1024 / reading. No pin, no divider, no extra current. The
+// ADC input stays on the bandgap, so there is no settling time per sample.
+//
+// readBandgap() busy-waits for its conversion (~104us at the core's /128 ADC
+// clock). It runs from its own scheduler task, so it never overlaps a show().
+// Readings are filtered with a Q8 fixed-point EMA and mapped to a tier with
+// hysteresis; policyFor() turns the tier into the ring's PowerPolicy. Both
+// take their thresholds and caps from a configuration type (config.h);
+// Monitor and the one-argument policyFor() use the build's Config.
+
+#if !defined(__AVR__)
+// Provided by the host simulation (replayed discharge curve).
+uint16_t hostReadBandgapAdc();
+#endif
+
+namespace Battery {
+
+// Select the bandgap once. The first sample is taken a BatterySampleMs later,
+// well after the bandgap has settled.
+inline void begin() {
+#if defined(__AVR__)
+  ADCSRB &= (uint8_t)~_BV(MUX5);
+  ADMUX = _BV(REFS0) | 0x1E; // AVcc reference, MUX4:0 = 11110 -> 1.1V bandgap
+#endif
+}
+
+inline uint16_t readBandgap() {
+#if defined(__AVR__)
+  ADCSRA |= _BV(ADSC);
+  while (ADCSRA & _BV(ADSC)) {
+  }
+  return ADC;
+#else
+  return hostReadBandgapAdc();
+#endif
+}
+
+enum class Tier : uint8_t {
+  Normal = 0,
+  Low = 1,
+  Critical = 2,
+};
+
+template <class Cfg> BasicPowerPolicy<Cfg> policyFor(Tier tier) {
+  BasicPowerPolicy<Cfg> p;
+  if (tier == Tier::Low) {
+    p.brightness = Cfg::BatteryLowBrightness;
+    p.sleepMs = Cfg::BatteryLowSleepMs;
+    p.maxActiveCycles = Cfg::BatteryLowActiveCycles;
+  } else if (tier == Tier::Critical) {
+    p.brightness = Cfg::BatteryCriticalBrightness;
+    p.sleepMs = Cfg::BatteryCriticalSleepMs;
+    p.maxActiveCycles = Cfg::BatteryCriticalActiveCycles;
+  }
+  return p;
+}
+
+inline PowerPolicy policyFor(Tier tier) { return policyFor<Config>(tier); }
+
+template <class Cfg> class BasicMonitor {
+public:
+  static_assert(Cfg::BatteryCriticalMv < Cfg::BatteryLowMv, "battery tiers must be in falling order");
+  static_assert(Cfg::BatteryCriticalBrightness <= Cfg::BatteryLowBrightness &&
+                    Cfg::BatteryLowBrightness <= Cfg::StripBrightness,
+                "battery tiers must not raise the brightness cap");
+
+  // Feed one bandgap reading. Returns true when the tier changes.
+  bool addSample(uint16_t adc) {
+    if (adc == 0) {
+      return false;
+    }
+    const uint32_t mvQ8 = ((uint32_t)Cfg::BandgapMv * 1024u / adc) << 8;
+    if (!primed) {
+      emaQ8 = mvQ8;
+      primed = true;
+    } else if (mvQ8 >= emaQ8) {
+      emaQ8 += (mvQ8 - emaQ8) >> Cfg::BatteryEmaShift;
+    } else {
+      emaQ8 -= (emaQ8 - mvQ8) >> Cfg::BatteryEmaShift;
+    }
+
+    const Tier next = tierFor(mv(), current);
+    if (next == current) {
+      return false;
+    }
+    current = next;
+    return true;
+  }
+
+  uint16_t mv() const { return (uint16_t)(emaQ8 >> 8); }
+  Tier tier() const { return current; }
+
+private:
+  // Falling voltage moves down at the threshold; rising voltage must clear
+  // the threshold by BatteryHysteresisMv to move back up.
+  static Tier tierFor(uint16_t mv, Tier from) {
+    const uint16_t up = Cfg::BatteryHysteresisMv;
+    if (mv < Cfg::BatteryCriticalMv || (from == Tier::Critical && mv < Cfg::BatteryCriticalMv + up)) {
+      return Tier::Critical;
+    }
+    if (mv < Cfg::BatteryLowMv || (from != Tier::Normal && mv < Cfg::BatteryLowMv + up)) {
+      return Tier::Low;
+    }
+    return Tier::Normal;
+  }
+
+  uint32_t emaQ8 = 0;
+  bool primed = false;
+  Tier current = Tier::Normal;
+};
+
+typedef BasicMonitor<Config> Monitor;
+
+} // namespace Battery
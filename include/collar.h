@@ -0,0 +1,246 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "battery.h"
+#include "config.h"
+#include "flight_recorder.h"
+#include "gestures.h"
+#include "led_ring.h"
+
+// ----------------------------
+// Collar
+// ----------------------------
+// Everything one collar knows about itself: its LED ring, remote edge
+// tracking and gestures, what the gestures do to the mode, the flight recorder
+// and the battery monitor. It reads no pins, clock or ADC and writes no log; main.cpp
+// feeds it from digitalRead(), millis() and readBandgap() and does the
+// printing. Nothing here is static, so a host driver can run as many collars
+// side by side as it likes (sim_fleet runs thousands across threads).
+//
+// The strip is passed in rather than owned: on the board it is bound to the
+// data pin, and main.cpp keeps it next to the other hardware.
+//
+// BasicCollar<Cfg> is a collar of one configuration type (config.h): ring,
+// gestures and battery tiers all take their constants from Cfg. Collar is the
+// build's own.
+
+template <class Cfg> class BasicCollar {
+public:
+  typedef BasicLedRingController<Cfg> Ring;
+  typedef Gesture::BasicEngine<Cfg> Gestures;
+
+  static constexpr uint8_t kRemoteCount = Cfg::RemotePinCount;
+
+  // Called for every mode change that goes through applyMode() or
+  // recordMode(), after the ring has switched.
+  typedef void (*ModeHook)(LedMode mode, Flight::Source source, void *user);
+
+  explicit BasicCollar(typename Ring::Strip &strip, ModeHook hook = nullptr, void *hookUser = nullptr)
+      : ledRing(strip), modeHook(hook), modeHookUser(hookUser) {}
+
+  Ring &ring() { return ledRing; }
+  const Ring &ring() const { return ledRing; }
+  Flight::BasicRecorder<Cfg> &flight() { return recorder; }
+  const Battery::BasicMonitor<Cfg> &battery() const { return monitor; }
+
+  // ---- remote ----
+
+  // Levels as read, true = HIGH (released, with INPUT_PULLUP). Edges are only
+  // tracked once the starting levels are known.
+  void beginRemotes(const bool *high) {
+    for (uint8_t i = 0; i < kRemoteCount; i++) {
+      lastHigh[i] = high[i];
+    }
+    remotesStarted = true;
+  }
+
+  // Returns a mask of the remotes whose level changed. Each edge goes to the
+  // flight recorder and the gesture engine, whose timeouts are checked first;
+  // recognized gestures wait for takeGesture(). Call it every input pass.
+  uint8_t pollRemotes(const bool *high, uint32_t nowMs) {
+    if (!remotesStarted) {
+      return 0;
+    }
+    gestureEngine.poll(nowMs);
+    uint8_t changed = 0;
+    for (uint8_t i = 0; i < kRemoteCount; i++) {
+      if (high[i] == lastHigh[i]) {
+        continue;
+      }
+      const bool wasHigh = lastHigh[i];
+      lastHigh[i] = high[i];
+      changed |= (uint8_t)(1u << i);
+      recorder.record(Flight::Event::RemoteEdge, Flight::edgeArg(i, high[i]), nowMs);
+      if (wasHigh && !high[i]) {
+        gestureEngine.press(i, nowMs);
+      } else {
+        gestureEngine.release(i, nowMs);
+      }
+    }
+    return changed;
+  }
+
+  bool remoteHigh(uint8_t i) const { return lastHigh[i]; }
+
+  // Bindings come from Cfg::remoteBindings(); a host driver may swap them.
+  Gestures &gestures() { return gestureEngine; }
+  bool pendingGestures() const { return gestureEngine.pending(); }
+  bool takeGesture(typename Gestures::Fired &out) { return gestureEngine.take(out); }
+
+  // Carry out a gesture's bound action.
+  void handleGesture(const typename Gestures::Fired &g, uint32_t nowMs) {
+    const LedMode current = ledRing.mode();
+    switch (g.action) {
+      // Solid color modes
+      case Cfg::RemoteAction::SolidUp:
+        applyMode(stepUpSolid(current), Flight::Source::Remote, nowMs);
+        break;
+      case Cfg::RemoteAction::SolidDown: {
+        const LedMode next = stepDownSolid(current);
+        applyMode(next, Flight::Source::Remote, nowMs, next == LedMode::Idle);
+        break;
+      }
+
+      // Animated modes
+      case Cfg::RemoteAction::AnimUp:
+        applyMode(stepUp(current), Flight::Source::Remote, nowMs);
+        break;
+      case Cfg::RemoteAction::AnimDown:
+        if (current == LedMode::Idle) {
+          applyMode(LedMode::Idle, Flight::Source::Remote, nowMs, true);
+        } else {
+          applyMode(stepDown(current), Flight::Source::Remote, nowMs);
+        }
+        break;
+
+      // Direct jumps
+      case Cfg::RemoteAction::Idle:
+        applyMode(LedMode::Idle, Flight::Source::Remote, nowMs, true);
+        break;
+      case Cfg::RemoteAction::Danger:
+        applyMode(LedMode::Danger, Flight::Source::Remote, nowMs);
+        break;
+
+      case Cfg::RemoteAction::None:
+      default:
+        break;
+    }
+  }
+
+  // ---- mode ----
+
+  // Mode change from a command or the remote: switch, record, notify.
+  void applyMode(LedMode m, Flight::Source source, uint32_t nowMs, bool forceRestart = false) {
+    ledRing.setMode(m, forceRestart);
+    recordMode(m, source, nowMs);
+  }
+
+  // For a change the ring already made (a sync beacon).
+  void recordMode(LedMode m, Flight::Source source, uint32_t nowMs) {
+    recorder.record(Flight::Event::Mode, Flight::modeArg(static_cast<uint8_t>(m), source), nowMs);
+    if (modeHook) {
+      modeHook(m, source, modeHookUser);
+    }
+  }
+
+  // ---- frame ----
+
+  void update(uint32_t animNowMs, uint32_t nowMs) {
+    const uint8_t powerBefore = ledRing.powerStateValue();
+    ledRing.update(animNowMs);
+    if (ledRing.powerStateValue() != powerBefore) {
+      recorder.recordCoalesced(Flight::Event::Power, ledRing.powerStateValue(), nowMs);
+    }
+  }
+
+  // ---- battery ----
+
+  // One bandgap reading. Returns true when the tier changed; the ring is
+  // already on the new tier's power policy by then.
+  bool addBatterySample(uint16_t adc, uint32_t nowMs) {
+    if (!monitor.addSample(adc)) {
+      return false;
+    }
+    ledRing.setPowerPolicy(Battery::policyFor<Cfg>(monitor.tier()));
+    recorder.record(Flight::Event::Battery, static_cast<uint8_t>(monitor.tier()), nowMs);
+    return true;
+  }
+
+private:
+  static LedMode stepUp(LedMode m) {
+    // Per request: Idle -> Peace -> Warning -> Danger (clamp at Danger).
+    switch (m) {
+      case LedMode::Idle:
+        return LedMode::Peace;
+      case LedMode::Peace:
+        return LedMode::Warning;
+      case LedMode::Warning:
+        return LedMode::Danger;
+      case LedMode::Danger:
+      default:
+        return LedMode::Danger;
+    }
+  }
+
+  static LedMode stepDown(LedMode m) {
+    // Danger -> Warning -> Peace -> Idle (clamp at Idle).
+    switch (m) {
+      case LedMode::Danger:
+        return LedMode::Warning;
+      case LedMode::Warning:
+        return LedMode::Peace;
+      case LedMode::Peace:
+      case LedMode::Idle:
+      default:
+        return LedMode::Idle;
+    }
+  }
+
+  static LedMode stepUpSolid(LedMode m) {
+    // Idle -> SolidGreen -> SolidYellow -> SolidRed (clamp at SolidRed).
+    switch (m) {
+      case LedMode::Idle:
+        return LedMode::SolidGreen;
+      case LedMode::SolidGreen:
+        return LedMode::SolidYellow;
+      case LedMode::SolidYellow:
+        return LedMode::SolidRed;
+      case LedMode::SolidRed:
+        return LedMode::SolidRed;
+      default:
+        // If currently in an animated mode, start solid sequence at green.
+        return LedMode::SolidGreen;
+    }
+  }
+
+  static LedMode stepDownSolid(LedMode m) {
+    // SolidRed -> SolidYellow -> SolidGreen -> Idle (clamp at Idle).
+    switch (m) {
+      case LedMode::SolidRed:
+        return LedMode::SolidYellow;
+      case LedMode::SolidYellow:
+        return LedMode::SolidGreen;
+      case LedMode::SolidGreen:
+        return LedMode::Idle;
+      case LedMode::Idle:
+        return LedMode::Idle;
+      default:
+        // If currently in an animated mode, pressing "down" goes to Idle/off.
+        return LedMode::Idle;
+    }
+  }
+
+  Ring ledRing;
+  Flight::BasicRecorder<Cfg> recorder;
+  Battery::BasicMonitor<Cfg> monitor;
+
+  bool lastHigh[kRemoteCount] = {};
+  bool remotesStarted = false;
+  Gestures gestureEngine;
+
+  ModeHook modeHook;
+  void *modeHookUser;
+};
+
+typedef BasicCollar<Config> Collar;
@@ -0,0 +1,346 @@
+#pragma once
+
+#include <Arduino.h>
+
+// ----------------------------
+// Config (tuning knobs)
+// ----------------------------
+// Every knob is a static constexpr member of a configuration type, so several
+// collar variants build from this one source. Variant::Defaults is the
+// reference collar (8-pixel ring on a Pro Micro); a variant derives from it and
+// redeclares only what differs. The build picks one with
+// -DTAMECOLLAR_VARIANT=<name> (one PlatformIO env per variant) and `Config`
+// names it from then on.
+//
+// The ring, gestures, battery tiers and Collar are templates on the
+// configuration type (BasicLedRingController<Cfg> and so on), and the usual
+// names are aliases for Config, so a host tool can run every variant side by
+// side. The log, scheduler, phase sync and flight recorder read Config
+// directly; they are per build, not per collar.
+namespace Variant {
+
+struct Defaults {
+  // Serial
+  static constexpr uint32_t SerialBaud = 9600;
+
+  // Serial logging
+  // Startup wait is useful on native-USB boards (like ATmega32U4) so the host can
+  // open the port and not miss the banner. Set to 0 to avoid waiting.
+  static constexpr uint16_t SerialStartupWaitMs = 300;
+
+  // Optional heartbeat log interval. Set to 0 to disable.
+  static constexpr uint32_t SerialHeartbeatMs = 0;
+
+  // Log output is queued in RAM and written out by a low-priority task, so a
+  // burst of log lines never stalls frames or input. Lines that don't fit are
+  // dropped (and counted) rather than blocking.
+  static constexpr uint16_t LogBufferBytes = 256;
+  static constexpr uint8_t LogLineMaxBytes = 80; // room needed before a report emits its next line
+
+  // Serial mode commands ('1'-'4') are acknowledged with ACK (0x06) followed by
+  // the command character once the new mode's first frame has been shown, so a
+  // console can measure command-to-light latency (src/host/tools/serial_bench.cpp).
+  // The two bytes go straight to Serial, ahead of queued log output.
+  static constexpr bool SerialModeAck = true;
+
+  // Main-loop task scheduler (see include/scheduler.h).
+  // Periods are in ms (0 = event-triggered); budgets are per run, in us.
+  static constexpr uint16_t FrameTaskPeriodMs = 1;
+  static constexpr uint16_t FrameTaskBudgetUs = 1000;
+  static constexpr uint16_t InputTaskPeriodMs = 1;
+  static constexpr uint16_t InputTaskBudgetUs = 100;
+  static constexpr uint16_t RemoteEventTaskBudgetUs = 500;
+  static constexpr uint16_t SerialTaskPeriodMs = 5;
+  static constexpr uint16_t SerialTaskBudgetUs = 300;
+  static constexpr uint16_t HeartbeatTaskBudgetUs = 300;
+  static constexpr uint16_t LogTaskPeriodMs = 2;
+  static constexpr uint16_t LogTaskBudgetUs = 300;
+  static constexpr uint16_t ReportTaskPeriodMs = 5;
+  static constexpr uint16_t ReportTaskBudgetUs = 500;
+
+  // Multi-collar phase sync (see include/phase_sync.h) over the hardware UART
+  // (Serial1: TX = pin 1, RX = pin 0). Wire the leader's TX to every follower's
+  // RX plus a common ground. The leader broadcasts its mode and animation
+  // position; followers slew their animation clock to match it.
+  enum class SyncRole : uint8_t {
+    Off = 0,
+    Leader = 1,
+    Follower = 2,
+  };
+  static constexpr SyncRole SyncRoleSetting = SyncRole::Off;
+  static constexpr uint32_t SyncBaud = 38400;
+  static constexpr uint16_t SyncBeaconMs = 500; // leader also sends on every mode change
+  static constexpr uint16_t SyncStepThresholdMs = 100; // bigger clock errors jump instead of slewing
+  static constexpr uint8_t SyncToleranceMs = 4; // animation steps this close count as in sync
+  static constexpr uint16_t SyncTaskBudgetUs = 300;
+
+  // Flight recorder (see include/flight_recorder.h): recent mode changes, remote
+  // edges, power-state changes and resets in RAM, checkpointed to EEPROM so they
+  // survive a power loss. Dump with the 'f' serial command.
+  static constexpr uint8_t FlightRecorderEvents = 32; // power of two, 6 bytes each
+  static constexpr uint32_t FlightCheckpointMs = 10000; // at most this often, and only after new events
+  static constexpr uint16_t FlightEepromBase = 0;
+  static constexpr uint16_t FlightEepromBytes = 1024;
+  static constexpr uint16_t FlightTaskPeriodMs = 4; // an EEPROM byte write takes ~3.4ms
+  static constexpr uint16_t FlightTaskBudgetUs = 300;
+
+  // Remote control input pins
+  static constexpr uint8_t RemotePin1 = 7;
+  static constexpr uint8_t RemotePin2 = 6;
+  static constexpr uint8_t RemotePin3 = 5;
+  static constexpr uint8_t RemotePin4 = 4;
+  static constexpr uint8_t RemotePinCount = 4;
+
+  static constexpr uint8_t RemoteIndexSolidUp = 0;   // REMOTE_PIN_1
+  static constexpr uint8_t RemoteIndexSolidDown = 1; // REMOTE_PIN_2
+  static constexpr uint8_t RemoteIndexAnimUp = 2;    // REMOTE_PIN_3
+  static constexpr uint8_t RemoteIndexAnimDown = 3;  // REMOTE_PIN_4
+
+  // Remote gestures (see include/gestures.h). Each binding maps a gesture on one
+  // button, or a chord on two, to an action. A button acts on the press edge
+  // unless it has a long press, a double press or a chord bound; then its tap
+  // waits until the other gestures are ruled out: release or ChordWindowMs for a
+  // chord member, release for a long press, DoubleGapMs after release for a
+  // double press. Chords fire on the second press, so the panic chord costs no
+  // more than one input poll.
+  enum class RemoteAction : uint8_t {
+    None = 0,
+    SolidUp = 1,   // Idle -> Green -> Yellow -> Red
+    SolidDown = 2, // back down to Idle
+    AnimUp = 3,    // Idle -> Peace -> Warning -> Danger
+    AnimDown = 4,  // back down to Idle
+    Idle = 5,
+    Danger = 6,
+  };
+
+  enum class RemoteGesture : uint8_t {
+    None = 0,
+    Tap = 1,
+    Double = 2, // second press within DoubleGapMs of the first release
+    Long = 3,   // held for LongPressMs
+    Chord = 4,  // two buttons pressed less than ChordWindowMs apart
+  };
+
+  struct RemoteBinding {
+    RemoteGesture gesture;
+    uint8_t buttons; // bit per RemoteIndex*; two bits for a chord
+    RemoteAction action;
+  };
+
+  static constexpr uint16_t RemoteLongPressMs = 600;
+  static constexpr uint16_t RemoteDoubleGapMs = 250;
+  static constexpr uint16_t RemoteChordWindowMs = 80;
+  // Edges within this of a button's last counted edge are contact chatter.
+  static constexpr uint16_t RemoteDebounceMs = 10;
+
+  // The table sits inside a function so that it is defined where it is
+  // written: a variant with its own bindings overrides remoteBindings() and
+  // needs no out-of-class definition anywhere else. It stays in flash; the
+  // gesture engine reads it with pgm_read_byte().
+  static const RemoteBinding *remoteBindings(uint8_t &count) {
+    static const RemoteBinding table[] PROGMEM = {
+        {RemoteGesture::Tap, 1u << RemoteIndexSolidUp, RemoteAction::SolidUp},
+        {RemoteGesture::Tap, 1u << RemoteIndexSolidDown, RemoteAction::SolidDown},
+        {RemoteGesture::Tap, 1u << RemoteIndexAnimUp, RemoteAction::AnimUp},
+        {RemoteGesture::Tap, 1u << RemoteIndexAnimDown, RemoteAction::AnimDown},
+        // Hold "animated down": straight back to Idle.
+        {RemoteGesture::Long, 1u << RemoteIndexAnimDown, RemoteAction::Idle},
+        // Panic: both "up" buttons together, straight to Danger.
+        {RemoteGesture::Chord, (1u << RemoteIndexSolidUp) | (1u << RemoteIndexAnimUp), RemoteAction::Danger},
+    };
+    count = sizeof(table) / sizeof(table[0]);
+    return table;
+  }
+
+  // WS2812 / NeoPixel
+  static constexpr uint8_t NeoPixelPin = A9;
+  static constexpr uint16_t PixelCount = 8;
+  static constexpr uint8_t StripBrightness = 30; // 0-255
+  // How far the ring is turned clockwise (seen from the front) from the
+  // reference mounting, LED1 just right of 12 o'clock. 1/256 turn: 32 = one
+  // pixel pitch on an 8-pixel ring. Directional effects (sweep start, left/right
+  // halves) follow it; see ring_geometry.h.
+  static constexpr uint8_t RingRotation = 0;
+
+  // Temporal dithering (see ws2812.h): levels between two output steps are
+  // shown by alternating them frame to frame, so fades and pulses at
+  // StripBrightness don't stair-step. While a dithered mode is lit the frame is
+  // re-sent every DitherFrameMs (~270us each on the Pro Micro). Danger is off so
+  // its strobes stay crisp.
+  static constexpr uint16_t DitherFrameMs = 2;
+  static constexpr bool DitherPeace = true;
+  static constexpr bool DitherWarning = true;
+  static constexpr bool DitherSolid = true;
+  static constexpr bool DitherDanger = false;
+
+  // Mode crossfade: on a mode change the frame on the ring is held and the new
+  // mode is blended in over it for ModeCrossfadeMs (one extra 24-byte buffer in
+  // the driver, blended in show()'s per-byte pass), resent every
+  // CrossfadeFrameMs so the blend moves even while the new mode holds a frame.
+  // 0 cuts hard, as before. Into Danger the cut stays hard unless
+  // CrossfadeIntoDanger: the alert has to show at once.
+  static constexpr uint16_t ModeCrossfadeMs = 200;
+  static constexpr uint16_t CrossfadeFrameMs = 5;
+  static constexpr bool CrossfadeIntoDanger = false;
+
+  // Power-saving loop (all modes except Danger)
+  static constexpr uint32_t SleepMs = 1000;
+  static constexpr uint32_t FadeMs = 250;
+  static constexpr uint8_t ActiveCycles = 2;
+  // Optional per-mode overrides for how many "cycles" to run each time we wake.
+  // (A cycle = one full animation pass that returns "cycle done").
+  static constexpr uint8_t ActiveCyclesPeace = 2;
+  static constexpr uint8_t ActiveCyclesWarning = 2;
+  static constexpr uint8_t ActiveCyclesSolid = 1;
+
+  // Battery-aware duty cycle (see include/battery.h). Vcc is measured against
+  // the internal 1.1V bandgap, so it follows the battery when the cell feeds VCC
+  // directly (or the regulator is in dropout). As the filtered voltage falls
+  // through the tiers, the power-saving loop dims, sleeps longer and runs fewer
+  // cycles per wake. Danger is never affected.
+  static constexpr bool BatteryAdaptive = true;
+  static constexpr uint16_t BandgapMv = 1100; // typical; 1.0-1.2V per chip, calibrate against a meter
+  static constexpr uint16_t BatterySampleMs = 1000;
+  static constexpr uint8_t BatteryEmaShift = 3; // each sample weighs 1/8
+  static constexpr uint16_t BatteryHysteresisMv = 50; // recover a tier only this far above its threshold
+  static constexpr uint16_t BatteryLowMv = 3800;
+  static constexpr uint8_t BatteryLowBrightness = 22;
+  static constexpr uint32_t BatteryLowSleepMs = 2000;
+  static constexpr uint8_t BatteryLowActiveCycles = 1;
+  static constexpr uint16_t BatteryCriticalMv = 3700;
+  static constexpr uint8_t BatteryCriticalBrightness = 14;
+  static constexpr uint32_t BatteryCriticalSleepMs = 5000;
+  static constexpr uint8_t BatteryCriticalActiveCycles = 1;
+  static constexpr uint16_t BatteryTaskBudgetUs = 200; // one conversion is ~104us
+
+  // Solid color mode
+  static constexpr uint16_t SolidHoldMs = 3000;
+
+  // Peace mode
+  static constexpr uint16_t PeaceChaseStepMs = 90;
+  static constexpr uint16_t PeaceChaseSteps = 24;
+  static constexpr uint16_t PeaceHoldMs = 600;
+  static constexpr uint8_t PeaceBackgroundScale = 40; // 0-255 dim green base
+  static constexpr uint8_t PeaceChaseWidth = 2;
+
+  static constexpr uint16_t PeacePulseStepMs = 45;
+  static constexpr uint16_t PeacePulseSteps = 60;
+  static constexpr uint8_t PeacePulseMinScale = 30;  // 0-255
+  static constexpr uint8_t PeacePulseMaxScale = 200; // 0-255
+
+  static constexpr uint16_t PeaceSparkleStepMs = 70;
+  static constexpr uint16_t PeaceSparkleSteps = 28;
+  static constexpr uint8_t PeaceSparkleCount = 3;
+  static constexpr uint8_t PeaceSparkleScale = 255; // 0-255
+  static constexpr uint8_t PeaceSprinkleScale = 200; // 0-255 (brightness for blue/cyan/purple sprinkles)
+
+  // Warning mode (yellow hazard + white strobe)
+  static constexpr uint16_t WarningChaseStepMs = 80;
+  static constexpr uint16_t WarningChaseLaps = 5;
+  static constexpr uint8_t WarningChaseWidth = 3;
+  static constexpr uint16_t WarningStrobeStepMs = 60;
+  static constexpr uint16_t WarningStrobeSteps = 14;
+  static constexpr uint8_t WarningStrobeWhiteScale = 140; // 0-255 (lower = dimmer strobe)
+
+  // Danger mode
+  static constexpr uint16_t DangerChaseLaps = 5;
+  static constexpr uint8_t DangerChaseWidth = 2;
+  static constexpr uint16_t DangerChaseStepMs = 60;
+  static constexpr uint16_t DangerPulseStepMs = 50;
+  static constexpr uint16_t DangerPulseSteps = 60;
+  static constexpr uint8_t DangerFlashEvery = 5;
+  static constexpr uint8_t DangerPulseBase = 80;
+  static constexpr uint16_t DangerPulseTrianglePeriod = 20;
+  static constexpr uint16_t DangerCopStepMs = 140;
+  static constexpr uint16_t DangerCopSteps = 30;
+
+  // Common colors
+  static constexpr uint8_t ColorYellowR = 255;
+  static constexpr uint8_t ColorYellowG = 180;
+  static constexpr uint8_t ColorYellowB = 0;
+
+  static constexpr uint8_t ColorGreenR = 0;
+  static constexpr uint8_t ColorGreenG = 255;
+  static constexpr uint8_t ColorGreenB = 0;
+
+  static constexpr uint8_t ColorRedR = 255;
+  static constexpr uint8_t ColorRedG = 0;
+  static constexpr uint8_t ColorRedB = 0;
+
+  static constexpr uint8_t ColorBlueR = 0;
+  static constexpr uint8_t ColorBlueG = 0;
+  static constexpr uint8_t ColorBlueB = 255;
+
+  static constexpr uint8_t ColorCyanR = 0;
+  static constexpr uint8_t ColorCyanG = 255;
+  static constexpr uint8_t ColorCyanB = 255;
+
+  static constexpr uint8_t ColorPurpleR = 170;
+  static constexpr uint8_t ColorPurpleG = 0;
+  static constexpr uint8_t ColorPurpleB = 255;
+
+  static constexpr uint8_t ColorWhiteR = 255;
+  static constexpr uint8_t ColorWhiteG = 255;
+  static constexpr uint8_t ColorWhiteB = 255;
+};
+
+// The reference build (env:sparkfun_promicro8): 8-pixel ring on A9.
+struct ProMicro8 : Defaults {};
+
+// 12-pixel ring on pin 10, for a bigger dog. Brightness caps are cut to keep
+// the LED current of the 8-pixel collar; chase steps are shorter so a lap takes
+// as long, and widths grow to cover the same arc.
+struct ProMicro12 : Defaults {
+  static constexpr uint8_t NeoPixelPin = 10;
+  static constexpr uint16_t PixelCount = 12;
+  static constexpr uint8_t StripBrightness = 20;
+  static constexpr uint8_t BatteryLowBrightness = 15;
+  static constexpr uint8_t BatteryCriticalBrightness = 9;
+
+  static constexpr uint16_t PeaceChaseStepMs = 60;
+  static constexpr uint16_t PeaceChaseSteps = 36;
+  static constexpr uint8_t PeaceChaseWidth = 3;
+  static constexpr uint8_t PeaceSparkleCount = 4;
+  static constexpr uint16_t WarningChaseStepMs = 53;
+  static constexpr uint8_t WarningChaseWidth = 4;
+  static constexpr uint16_t DangerChaseStepMs = 40;
+  static constexpr uint8_t DangerChaseWidth = 3;
+};
+
+// 16-pixel ring on pin 16 (PB2; pin 9 would be PB5, the same pin as A9),
+// remote receiver on the A0-A3 header. Same current
+// budget and lap times as above. A frame takes ~530us to send, so dithered
+// modes resend every 4ms instead of 2ms.
+struct ProMicro16 : Defaults {
+  static constexpr uint8_t RemotePin1 = A0;
+  static constexpr uint8_t RemotePin2 = A1;
+  static constexpr uint8_t RemotePin3 = A2;
+  static constexpr uint8_t RemotePin4 = A3;
+
+  static constexpr uint8_t NeoPixelPin = 16;
+  static constexpr uint16_t PixelCount = 16;
+  static constexpr uint8_t StripBrightness = 15;
+  static constexpr uint8_t BatteryLowBrightness = 11;
+  static constexpr uint8_t BatteryCriticalBrightness = 7;
+  static constexpr uint16_t DitherFrameMs = 4;
+
+  static constexpr uint16_t PeaceChaseStepMs = 45;
+  static constexpr uint16_t PeaceChaseSteps = 48;
+  static constexpr uint8_t PeaceChaseWidth = 4;
+  static constexpr uint8_t PeaceSparkleCount = 6;
+  static constexpr uint16_t WarningChaseStepMs = 40;
+  static constexpr uint8_t WarningChaseWidth = 6;
+  static constexpr uint16_t DangerChaseStepMs = 30;
+  static constexpr uint8_t DangerChaseWidth = 4;
+};
+
+} // namespace Variant
+
+#if !defined(TAMECOLLAR_VARIANT)
+#define TAMECOLLAR_VARIANT ProMicro8
+#endif
+#define TAMECOLLAR_STRINGIFY_(x) #x
+#define TAMECOLLAR_STRINGIFY(x) TAMECOLLAR_STRINGIFY_(x)
+#define TAMECOLLAR_VARIANT_NAME TAMECOLLAR_STRINGIFY(TAMECOLLAR_VARIANT)
+
+typedef Variant::TAMECOLLAR_VARIANT Config;
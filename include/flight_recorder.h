@@ -0,0 +1,320 @@
+#pragma once
+
+#include <Arduino.h>
+#include <EEPROM.h>
+
+#include "config.h"
+
+// ----------------------------
+// Flight recorder
+// ----------------------------
+// Always-on log of what the collar did, readable after the fact with the 'f'
+// serial command. Events go into a small RAM ring (Recorder::record() is a
+// handful of stores, no I/O) and the entries recorded since the last
+// checkpoint are appended to EEPROM now and then (Checkpoints), one byte per
+// call so the copy never holds up a frame.
+//
+// EEPROM is a circular log of Cfg::FlightEepromBytes / kRecordBytes records,
+// one entry each: [entry, seq lo, seq hi, check], the check written last so a
+// record cut short by power loss fails it. seq counts records across sessions.
+// At boot the newest record and the ones before it, back to its session's Boot
+// entry, are the previous session. They are skipped over while this session
+// appends, so the previous session can always be dumped.
+//
+// Wear: a cell is rewritten once per trip around the log, not per checkpoint.
+// The 1KB default holds 113 records, at least 81 of them outside the previous
+// session. A mode change from the remote every 10 seconds, non-stop (3
+// entries), takes a cell to 100k writes in about 350 days (sim_flight). When
+// every checkpoint rewrote a whole-ring slot, one of 4, it took 46 days.
+
+namespace Flight {
+
+enum class Event : uint8_t {
+  Boot = 1,       // arg: MCUSR reset flags (0 if the bootloader cleared them)
+  Mode = 2,       // arg: modeArg()
+  RemoteEdge = 3, // arg: edgeArg()
+  Power = 4,      // arg: LedRingController::powerStateValue()
+  Battery = 5,    // arg: Battery::Tier
+};
+
+enum class Source : uint8_t {
+  Remote = 0,
+  Serial = 1,
+  Sync = 2,
+};
+
+struct Entry {
+  uint32_t ms;
+  Event event;
+  uint8_t arg;
+};
+
+static constexpr uint8_t kEntryBytes = 6;
+
+inline uint8_t modeArg(uint8_t mode, Source source) { return (uint8_t)(mode | (static_cast<uint8_t>(source) << 4)); }
+inline uint8_t edgeArg(uint8_t remoteIndex, bool high) { return (uint8_t)(remoteIndex | (high ? 0x80 : 0)); }
+
+// Reset cause for the Boot event. Clears the flags so the next reset reports
+// only its own cause.
+inline uint8_t takeResetFlags() {
+  const uint8_t flags = MCUSR;
+  MCUSR = 0;
+  return flags;
+}
+
+template <class Cfg> class BasicRecorder {
+public:
+  static constexpr uint8_t kCapacity = Cfg::FlightRecorderEvents;
+  static_assert(kCapacity != 0 && (kCapacity & (kCapacity - 1)) == 0, "FlightRecorderEvents must be a power of two");
+
+  void record(Event event, uint8_t arg, uint32_t ms) {
+    Entry &e = entries[head];
+    e.ms = ms;
+    e.event = event;
+    e.arg = arg;
+    head = (uint8_t)((head + 1) & (kCapacity - 1));
+    if (stored < kCapacity) {
+      stored++;
+    }
+    total++;
+    dirty = true;
+  }
+
+  // For routine events (power-state cycling): replaces the newest entry if it
+  // is the same kind, so a sleep/wake loop occupies one entry instead of
+  // flushing the ring, and doesn't by itself trigger a checkpoint.
+  void recordCoalesced(Event event, uint8_t arg, uint32_t ms) {
+    if (stored != 0) {
+      Entry &last = entries[(uint8_t)((head - 1) & (kCapacity - 1))];
+      if (last.event == event) {
+        last.ms = ms;
+        last.arg = arg;
+        amended = amended || (saved != 0 && total == saved);
+        return;
+      }
+    }
+    record(event, arg, ms);
+  }
+
+  uint8_t count() const { return stored; }
+  // Entries pushed out of the ring since boot.
+  uint16_t lost() const { return (uint16_t)(total - stored); }
+  uint16_t recorded() const { return total; }
+
+  // 0 = newest.
+  const Entry &newest(uint8_t i) const { return entries[(uint8_t)((head - 1 - i) & (kCapacity - 1))]; }
+
+  bool hasNewEvents() const { return dirty; }
+  // recorded() as of the last checkpoint, and whether the newest entry it
+  // wrote has been coalesced into since.
+  uint16_t checkpointed() const { return saved; }
+  bool checkpointAmended() const { return amended; }
+  void markCheckpointed() {
+    saved = total;
+    dirty = false;
+    amended = false;
+  }
+
+private:
+  Entry entries[kCapacity] = {};
+  uint8_t head = 0;
+  uint8_t stored = 0;
+  uint16_t total = 0;
+  uint16_t saved = 0;
+  bool dirty = false;
+  bool amended = false;
+};
+
+template <class Cfg> class BasicCheckpoints {
+public:
+  typedef BasicRecorder<Cfg> Recorder;
+
+  static constexpr uint8_t kRecordBytes = kEntryBytes + 3;
+  static constexpr uint8_t kRecords = (uint8_t)(Cfg::FlightEepromBytes / kRecordBytes);
+  static_assert(Cfg::FlightEepromBytes / kRecordBytes < 0xFF, "FlightEepromBytes: record positions are a uint8_t");
+  static_assert(kRecords >= 2 * Recorder::kCapacity,
+                "FlightEepromBytes must hold the previous session and as much again");
+
+  // Find the newest valid record and walk back to its session's Boot entry:
+  // that is the previous session.
+  void begin() {
+    previousNewest = kNone;
+    previousEntries = 0;
+    for (uint8_t i = 0; i < sizeof(previousMap); i++) {
+      previousMap[i] = 0;
+    }
+    uint16_t bestSeq = 0;
+    for (uint8_t p = 0; p < kRecords; p++) {
+      uint16_t seq = 0;
+      Event event;
+      if (readRecord(p, seq, event) && (previousNewest == kNone || (int16_t)(seq - bestSeq) > 0)) {
+        previousNewest = p;
+        bestSeq = seq;
+      }
+    }
+    nextSeq = (uint16_t)(bestSeq + 1);
+    head = previousNewest;
+    writing = false;
+    if (previousNewest == kNone) {
+      return;
+    }
+
+    // That session appended around the sessions before it, so the record
+    // before each one is the nearest earlier position with the seq before.
+    uint8_t p = previousNewest;
+    uint16_t seq = bestSeq;
+    Event event;
+    readRecord(p, seq, event);
+    markPrevious(p);
+    previousEntries = 1;
+    uint8_t steps = 0;
+    while (event != Event::Boot && previousEntries < Recorder::kCapacity) {
+      uint16_t found = 0;
+      do {
+        p = (p == 0) ? (uint8_t)(kRecords - 1) : (uint8_t)(p - 1);
+      } while (++steps < kRecords && (!readRecord(p, found, event) || found != (uint16_t)(seq - 1)));
+      if (steps >= kRecords) {
+        break;
+      }
+      markPrevious(p);
+      seq = found;
+      previousEntries++;
+    }
+  }
+
+  bool hasPrevious() const { return previousEntries != 0; }
+  uint8_t previousCount() const { return previousEntries; }
+
+  // 0 = newest. Only call while eeprom_is_ready().
+  Entry previous(uint8_t i) const {
+    uint8_t p = previousNewest;
+    while (true) {
+      if (previousHolds(p) && i-- == 0) {
+        break;
+      }
+      p = (p == 0) ? (uint8_t)(kRecords - 1) : (uint8_t)(p - 1);
+    }
+    const uint16_t at = recordAddr(p);
+    Entry e;
+    e.ms = (uint32_t)EEPROM.read(at) | ((uint32_t)EEPROM.read(at + 1) << 8) | ((uint32_t)EEPROM.read(at + 2) << 16) |
+           ((uint32_t)EEPROM.read(at + 3) << 24);
+    e.event = static_cast<Event>(EEPROM.read(at + 4));
+    e.arg = EEPROM.read(at + 5);
+    return e;
+  }
+
+  bool busy() const { return writing; }
+
+  // Begin appending what the recorder holds beyond its last checkpoint. If
+  // the newest entry already written has been coalesced into since, its
+  // record is rewritten in place first.
+  void start(const Recorder &r) {
+    const bool amend = r.checkpointAmended() && head != kNone;
+    next = (uint16_t)(r.checkpointed() - (amend ? 1 : 0));
+    endTotal = r.recorded();
+    pos = amend ? head : after(head);
+    recordSeq = amend ? (uint16_t)(nextSeq - 1) : nextSeq;
+    byteIndex = 0;
+    writing = true;
+  }
+
+  // Write the next byte if the EEPROM is free. Returns false when it had to
+  // wait (a previous byte is still being written) or the checkpoint is done.
+  bool step(const Recorder &r) {
+    if (!writing || !eeprom_is_ready()) {
+      return false;
+    }
+
+    if (byteIndex == 0) {
+      // Oldest first. Entries pushed out of the ring since start() are gone;
+      // the next one takes their place in the sequence.
+      while (next != endTotal && (uint16_t)(r.recorded() - next) > r.count()) {
+        next++;
+      }
+      if (next == endTotal) {
+        writing = false;
+        return false;
+      }
+      pending = r.newest((uint8_t)(r.recorded() - 1 - next));
+      check = kMagic;
+    }
+
+    uint8_t b;
+    if (byteIndex < 4) {
+      b = (uint8_t)(pending.ms >> (8 * byteIndex));
+    } else if (byteIndex == 4) {
+      b = static_cast<uint8_t>(pending.event);
+    } else if (byteIndex == 5) {
+      b = pending.arg;
+    } else if (byteIndex == 6) {
+      b = (uint8_t)recordSeq;
+    } else if (byteIndex == 7) {
+      b = (uint8_t)(recordSeq >> 8);
+    } else {
+      b = check;
+    }
+    EEPROM.update(recordAddr(pos) + byteIndex, b);
+    check = mix(check, b);
+
+    if (++byteIndex == kRecordBytes) {
+      head = pos;
+      nextSeq = (uint16_t)(recordSeq + 1);
+      recordSeq = nextSeq;
+      next++;
+      pos = after(pos);
+      byteIndex = 0;
+    }
+    return true;
+  }
+
+private:
+  static constexpr uint8_t kNone = 0xFF;
+  static constexpr uint8_t kMagic = 0xFC;
+
+  static uint8_t mix(uint8_t check, uint8_t b) { return (uint8_t)(((check << 1) | (check >> 7)) ^ b); }
+
+  static uint16_t recordAddr(uint8_t p) { return (uint16_t)(Cfg::FlightEepromBase + (uint16_t)p * kRecordBytes); }
+
+  static bool readRecord(uint8_t p, uint16_t &seq, Event &event) {
+    const uint16_t at = recordAddr(p);
+    uint8_t check = kMagic;
+    for (uint8_t i = 0; i < kRecordBytes - 1; i++) {
+      check = mix(check, EEPROM.read(at + i));
+    }
+    event = static_cast<Event>(EEPROM.read(at + 4));
+    seq = (uint16_t)(EEPROM.read(at + 6) | (EEPROM.read(at + 7) << 8));
+    return check == EEPROM.read(at + kRecordBytes - 1) && event >= Event::Boot && event <= Event::Battery;
+  }
+
+  // Whether record position p holds one of the previous session's entries.
+  bool previousHolds(uint8_t p) const { return (previousMap[p >> 3] >> (p & 7)) & 1; }
+  void markPrevious(uint8_t p) { previousMap[p >> 3] |= (uint8_t)(1u << (p & 7)); }
+
+  // The position to append at after p (kNone: the log is empty).
+  uint8_t after(uint8_t p) const {
+    do {
+      p = (p == kNone || p + 1 == kRecords) ? 0 : (uint8_t)(p + 1);
+    } while (previousHolds(p));
+    return p;
+  }
+
+  uint8_t previousNewest = kNone;
+  uint8_t previousEntries = 0;
+  uint8_t previousMap[(kRecords + 7) / 8] = {}; // bit per record position
+  uint8_t head = kNone; // newest record written
+  uint16_t nextSeq = 0;
+
+  bool writing = false;
+  uint16_t next = 0;     // recorded() index of the entry being written
+  uint16_t endTotal = 0; // recorded() at start()
+  uint8_t pos = 0;
+  uint16_t recordSeq = 0;
+  uint8_t byteIndex = 0;
+  uint8_t check = 0;
+  Entry pending = {};
+};
+
+typedef BasicRecorder<Config> Recorder;
+typedef BasicCheckpoints<Config> Checkpoints;
+
+} // namespace Flight
@@ -0,0 +1,313 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "config.h"
+
+// ----------------------------
+// Remote gestures
+// ----------------------------
+// Turns press and release edges (with their times) into taps, double presses,
+// long presses and two-button chords, then looks each one up in the
+// configuration's remoteBindings() (config.h). Nothing waits or blocks: every
+// button is a small state machine that moves on an edge or when its state's
+// timeout has passed, and poll() checks the timeouts. Call press()/release() as edges are seen and
+// poll() on every input pass; the timeout resolution is the poll period.
+//
+// Edges are debounced first. An edge counts at once if the button's last
+// counted edge is RemoteDebounceMs old, so a press still acts without delay.
+// Edges inside that window are not counted, but the level they leave is: if it
+// differs from the counted one once the window has passed, poll() counts it
+// then. Contact chatter on a press or release therefore reads as one edge.
+//
+// The state machine is the engine's rules() table, first matching rule wins. It
+// and the binding table live in flash (PROGMEM) and are read a byte at a time. Which
+// rules can match depends on what the button has bound: a button with only a
+// tap acts on the press, with no delay. Chords are checked on each press before
+// the table. A press on a button whose chord partner is still Down, and was
+// pressed less than RemoteChordWindowMs ago, fires the chord and holds both
+// buttons until they are released.
+
+namespace Gesture {
+
+enum class State : uint8_t {
+  Up = 0,   // released, nothing pending
+  Down = 1, // pressed, gesture not decided yet
+  Gap = 2,  // released after a tap that may become a double press
+  Held = 3, // gesture fired; ignore the button until it is released
+};
+
+enum class Input : uint8_t {
+  Press = 0,
+  Release = 1,
+  Timeout = 2,
+};
+
+enum class Guard : uint8_t {
+  Always = 0,
+  TapOnly = 1,   // nothing but a tap bound: no reason to wait
+  HasDouble = 2,
+  HasLong = 3,
+};
+
+template <class Cfg> class BasicEngine {
+public:
+  typedef typename Cfg::RemoteAction RemoteAction;
+  typedef typename Cfg::RemoteBinding RemoteBinding;
+  typedef typename Cfg::RemoteGesture RemoteGesture;
+
+  // A recognized gesture with a bound action.
+  struct Fired {
+    RemoteGesture gesture;
+    uint8_t buttons;     // bit per remote
+    RemoteAction action;
+    uint32_t startMs;    // first press of the gesture
+    uint32_t atMs;       // when it was recognized
+  };
+
+  static constexpr uint8_t kButtons = Cfg::RemotePinCount;
+  static constexpr uint8_t kQueue = 4;
+
+  static_assert(kButtons <= 8, "Gesture: buttons are a uint8_t bit mask");
+
+  BasicEngine() {
+    uint8_t count;
+    const RemoteBinding *table = Cfg::remoteBindings(count);
+    setBindings(table, count);
+  }
+
+  // The table is used in place, must be in PROGMEM and must outlive the
+  // engine. Resets every button to Up and released.
+  void setBindings(const RemoteBinding *table, uint8_t count) {
+    bindings = table;
+    bindingCount = count;
+    longMask = doubleMask = chordMask = 0;
+    for (uint8_t i = 0; i < count; i++) {
+      const RemoteBinding binding = bindingAt(i);
+      if (binding.action == RemoteAction::None) {
+        continue;
+      }
+      if (binding.gesture == RemoteGesture::Long) {
+        longMask |= binding.buttons;
+      } else if (binding.gesture == RemoteGesture::Double) {
+        doubleMask |= binding.buttons;
+      } else if (binding.gesture == RemoteGesture::Chord) {
+        chordMask |= binding.buttons;
+      }
+    }
+    for (uint8_t b = 0; b < kButtons; b++) {
+      state[b] = State::Up;
+    }
+    levelDown = countedDown = 0;
+    queued = 0;
+  }
+
+  void press(uint8_t b, uint32_t nowMs) { edge(b, true, nowMs); }
+
+  void release(uint8_t b, uint32_t nowMs) { edge(b, false, nowMs); }
+
+  void poll(uint32_t nowMs) {
+    for (uint8_t b = 0; b < kButtons; b++) {
+      const uint8_t bit = (uint8_t)(1u << b);
+      if (((levelDown ^ countedDown) & bit) && nowMs - edgeMs[b] >= Cfg::RemoteDebounceMs) {
+        countEdge(b, (levelDown & bit) != 0, nowMs);
+      }
+      const uint16_t after = timeoutFor(b);
+      if (after != 0 && nowMs - sinceMs[b] >= after) {
+        step(b, Input::Timeout, nowMs);
+      }
+    }
+  }
+
+  bool pending() const { return queued != 0; }
+
+  bool take(Fired &out) {
+    if (queued == 0) {
+      return false;
+    }
+    out = queue[head];
+    head = (uint8_t)((head + 1) % kQueue);
+    queued--;
+    return true;
+  }
+
+  // Gestures lost because kQueue were already waiting (wraps).
+  uint8_t dropped() const { return drops; }
+
+  State buttonState(uint8_t b) const { return state[b]; }
+
+private:
+  struct Rule {
+    State from;
+    Input input;
+    Guard guard;
+    State to;
+    RemoteGesture fires;
+  };
+
+  static const Rule *rules(uint8_t &count) {
+    static const Rule table[] PROGMEM = {
+        {State::Up, Input::Press, Guard::TapOnly, State::Held, RemoteGesture::Tap},
+        {State::Up, Input::Press, Guard::Always, State::Down, RemoteGesture::None},
+        {State::Down, Input::Release, Guard::HasDouble, State::Gap, RemoteGesture::None},
+        {State::Down, Input::Release, Guard::Always, State::Up, RemoteGesture::Tap},
+        {State::Down, Input::Timeout, Guard::HasLong, State::Held, RemoteGesture::Long},
+        {State::Down, Input::Timeout, Guard::Always, State::Held, RemoteGesture::Tap}, // chord window passed
+        {State::Gap, Input::Press, Guard::Always, State::Held, RemoteGesture::Double},
+        {State::Gap, Input::Timeout, Guard::Always, State::Up, RemoteGesture::Tap},
+        {State::Held, Input::Release, Guard::Always, State::Up, RemoteGesture::None},
+    };
+    count = sizeof(table) / sizeof(table[0]);
+    return table;
+  }
+
+  // Every edge updates the level; it is counted only if the last counted edge
+  // is RemoteDebounceMs old. poll() counts a level left behind by the window.
+  void edge(uint8_t b, bool down, uint32_t nowMs) {
+    const uint8_t bit = (uint8_t)(1u << b);
+    levelDown = down ? (uint8_t)(levelDown | bit) : (uint8_t)(levelDown & ~bit);
+    if (((levelDown ^ countedDown) & bit) && nowMs - edgeMs[b] >= Cfg::RemoteDebounceMs) {
+      countEdge(b, down, nowMs);
+    }
+  }
+
+  void countEdge(uint8_t b, bool down, uint32_t nowMs) {
+    const uint8_t bit = (uint8_t)(1u << b);
+    countedDown ^= bit;
+    edgeMs[b] = nowMs;
+    if (!down) {
+      step(b, Input::Release, nowMs);
+      return;
+    }
+    if (state[b] == State::Up || state[b] == State::Down) {
+      const uint8_t bit = (uint8_t)(1u << b);
+      for (uint8_t o = 0; o < kButtons && (chordMask & bit); o++) {
+        const uint8_t pair = (uint8_t)(bit | (1u << o));
+        if (o == b || state[o] != State::Down || nowMs - sinceMs[o] >= Cfg::RemoteChordWindowMs) {
+          continue;
+        }
+        const RemoteAction action = lookup(RemoteGesture::Chord, pair);
+        if (action != RemoteAction::None) {
+          emit(RemoteGesture::Chord, pair, action, startMs[o], nowMs);
+          state[b] = state[o] = State::Held;
+          return;
+        }
+      }
+    }
+    step(b, Input::Press, nowMs);
+  }
+
+  bool guardHolds(Guard g, uint8_t bit) const {
+    switch (g) {
+      case Guard::TapOnly:
+        return ((longMask | doubleMask | chordMask) & bit) == 0;
+      case Guard::HasDouble:
+        return (doubleMask & bit) != 0;
+      case Guard::HasLong:
+        return (longMask & bit) != 0;
+      case Guard::Always:
+      default:
+        return true;
+    }
+  }
+
+  // 0 = the state never times out.
+  uint16_t timeoutFor(uint8_t b) const {
+    const uint8_t bit = (uint8_t)(1u << b);
+    if (state[b] == State::Down) {
+      if (longMask & bit) {
+        return Cfg::RemoteLongPressMs;
+      }
+      return ((chordMask & bit) && !(doubleMask & bit)) ? Cfg::RemoteChordWindowMs : 0;
+    }
+    return (state[b] == State::Gap) ? Cfg::RemoteDoubleGapMs : 0;
+  }
+
+  void step(uint8_t b, Input input, uint32_t nowMs) {
+    const uint8_t bit = (uint8_t)(1u << b);
+    uint8_t ruleCount;
+    const Rule *table = rules(ruleCount);
+    for (uint8_t r = 0; r < ruleCount; r++) {
+      const Rule rule = ruleAt(table, r);
+      if (rule.from != state[b] || rule.input != input || !guardHolds(rule.guard, bit)) {
+        continue;
+      }
+      if (state[b] == State::Up && input == Input::Press) {
+        startMs[b] = nowMs;
+      }
+      state[b] = rule.to;
+      sinceMs[b] = nowMs;
+      if (rule.fires != RemoteGesture::None) {
+        const RemoteAction action = lookup(rule.fires, bit);
+        if (action != RemoteAction::None) {
+          emit(rule.fires, bit, action, startMs[b], nowMs);
+        }
+      }
+      return;
+    }
+  }
+
+  RemoteAction lookup(RemoteGesture g, uint8_t buttons) const {
+    for (uint8_t i = 0; i < bindingCount; i++) {
+      const RemoteBinding binding = bindingAt(i);
+      if (binding.gesture == g && binding.buttons == buttons) {
+        return binding.action;
+      }
+    }
+    return RemoteAction::None;
+  }
+
+  static Rule ruleAt(const Rule *table, uint8_t r) {
+    Rule rule;
+    rule.from = static_cast<State>(pgm_read_byte(&table[r].from));
+    rule.input = static_cast<Input>(pgm_read_byte(&table[r].input));
+    rule.guard = static_cast<Guard>(pgm_read_byte(&table[r].guard));
+    rule.to = static_cast<State>(pgm_read_byte(&table[r].to));
+    rule.fires = static_cast<RemoteGesture>(pgm_read_byte(&table[r].fires));
+    return rule;
+  }
+
+  RemoteBinding bindingAt(uint8_t i) const {
+    RemoteBinding binding;
+    binding.gesture = static_cast<RemoteGesture>(pgm_read_byte(&bindings[i].gesture));
+    binding.buttons = pgm_read_byte(&bindings[i].buttons);
+    binding.action = static_cast<RemoteAction>(pgm_read_byte(&bindings[i].action));
+    return binding;
+  }
+
+  void emit(RemoteGesture g, uint8_t buttons, RemoteAction action, uint32_t fromMs, uint32_t nowMs) {
+    if (queued == kQueue) {
+      drops++;
+      return;
+    }
+    Fired &f = queue[(uint8_t)((head + queued) % kQueue)];
+    f.gesture = g;
+    f.buttons = buttons;
+    f.action = action;
+    f.startMs = fromMs;
+    f.atMs = nowMs;
+    queued++;
+  }
+
+  const RemoteBinding *bindings = nullptr;
+  uint8_t bindingCount = 0;
+  uint8_t longMask = 0;
+  uint8_t doubleMask = 0;
+  uint8_t chordMask = 0;
+  uint8_t levelDown = 0;   // bit per button, as last seen
+  uint8_t countedDown = 0; // bit per button, as last counted
+
+  State state[kButtons] = {};
+  uint32_t sinceMs[kButtons] = {}; // entered the current state
+  uint32_t startMs[kButtons] = {}; // first press of the gesture under way
+  uint32_t edgeMs[kButtons] = {};  // last counted edge
+
+  Fired queue[kQueue] = {};
+  uint8_t head = 0;
+  uint8_t queued = 0;
+  uint8_t drops = 0;
+};
+
+typedef BasicEngine<Config> Engine;
+
+} // namespace Gesture
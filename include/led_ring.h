@@ -0,0 +1,756 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "config.h"
+#include "ring_geometry.h"
+
+// Pixel output. The default is the compile-time-pinned driver in ws2812.h;
+// TAMECOLLAR_ADAFRUIT_NEOPIXEL builds against the Adafruit library instead so
+// the two can be compared (env:sparkfun_promicro8_adafruit).
+#if defined(TAMECOLLAR_ADAFRUIT_NEOPIXEL)
+#include <Adafruit_NeoPixel.h>
+template <class Cfg> using PixelStripFor = Adafruit_NeoPixel;
+#else
+#include "ws2812.h"
+template <class Cfg> using PixelStripFor = Ws2812<Cfg::NeoPixelPin, Cfg::PixelCount, NEO_GRB>;
+#endif
+typedef PixelStripFor<Config> PixelStrip;
+
+// Fine brightness (8.8), dithering and crossfades exist only in ws2812.h; the
+// Adafruit build falls back to whole brightness steps and hard mode cuts.
+#if defined(TAMECOLLAR_ADAFRUIT_NEOPIXEL)
+inline void setStripLevel(PixelStrip &s, uint16_t level) { s.setBrightness((uint8_t)(level >> 8)); }
+inline void setStripDither(PixelStrip &, bool) {}
+inline void holdStripFrame(PixelStrip &) {}
+inline void setStripMix(PixelStrip &, uint8_t) {}
+inline void releaseStripFrame(PixelStrip &) {}
+#else
+template <class Strip> inline void setStripLevel(Strip &s, uint16_t level) { s.setBrightnessFine(level); }
+template <class Strip> inline void setStripDither(Strip &s, bool on) { s.setDither(on); }
+template <class Strip> inline void holdStripFrame(Strip &s) { s.holdFrame(); }
+template <class Strip> inline void setStripMix(Strip &s, uint8_t mix) { s.setMix(mix); }
+template <class Strip> inline void releaseStripFrame(Strip &s) { s.releaseFrame(); }
+#endif
+
+static constexpr uint16_t PIXEL_COUNT = Config::PixelCount;
+
+static constexpr uint8_t STRIP_BRIGHTNESS = Config::StripBrightness; // 0-255
+
+// Ring mapping convention (as requested):
+// - LED 1 is the top-right
+// - LEDs increase clockwise
+// - LED 8 is the top-left
+// In code, we use 0-based indices: LED1 -> index 0, LED8 -> index 7.
+// Effects that care about direction go through ring_geometry.h rather than
+// index arithmetic, so they follow RingRotation.
+
+enum class LedMode : uint8_t {
+  Idle = 1,
+  Peace = 2,
+  Warning = 3,
+  Danger = 4,
+  SolidGreen = 5,
+  SolidYellow = 6,
+  SolidRed = 7,
+};
+
+// PixelStrip::Color() packs colors as 0x00RRGGBB (both drivers); these do the
+// same at compile time so fixed colors cost nothing at runtime.
+static constexpr uint32_t packColor(uint8_t r, uint8_t g, uint8_t b) {
+  return ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+}
+
+static constexpr uint32_t scaleColor(uint32_t color, uint8_t scale) {
+  return packColor((uint8_t)((uint16_t)((color >> 16) & 0xFF) * scale / 255),
+                   (uint8_t)((uint16_t)((color >> 8) & 0xFF) * scale / 255),
+                   (uint8_t)((uint16_t)(color & 0xFF) * scale / 255));
+}
+
+// Every color the modes draw with, other than the pulse ramps (which scale by
+// the current step). Folded into immediates, so render paths pay for neither
+// the packing nor scaleColor()'s three divides, which used to run on every
+// loop() pass in Peace.
+template <class Cfg> struct PaletteFor {
+  static constexpr uint32_t Green = packColor(Cfg::ColorGreenR, Cfg::ColorGreenG, Cfg::ColorGreenB);
+  static constexpr uint32_t Yellow = packColor(Cfg::ColorYellowR, Cfg::ColorYellowG, Cfg::ColorYellowB);
+  static constexpr uint32_t Red = packColor(Cfg::ColorRedR, Cfg::ColorRedG, Cfg::ColorRedB);
+  static constexpr uint32_t Blue = packColor(Cfg::ColorBlueR, Cfg::ColorBlueG, Cfg::ColorBlueB);
+  static constexpr uint32_t Cyan = packColor(Cfg::ColorCyanR, Cfg::ColorCyanG, Cfg::ColorCyanB);
+  static constexpr uint32_t Purple = packColor(Cfg::ColorPurpleR, Cfg::ColorPurpleG, Cfg::ColorPurpleB);
+  static constexpr uint32_t White = packColor(Cfg::ColorWhiteR, Cfg::ColorWhiteG, Cfg::ColorWhiteB);
+
+  static constexpr uint32_t PeaceBackground = scaleColor(Green, Cfg::PeaceBackgroundScale);
+  static constexpr uint32_t PeaceSparkle = scaleColor(Green, Cfg::PeaceSparkleScale);
+  static constexpr uint32_t PeaceSprinkleBlue = scaleColor(Blue, Cfg::PeaceSprinkleScale);
+  static constexpr uint32_t PeaceSprinkleCyan = scaleColor(Cyan, Cfg::PeaceSprinkleScale);
+  static constexpr uint32_t PeaceSprinklePurple = scaleColor(Purple, Cfg::PeaceSprinkleScale);
+  static constexpr uint32_t WarningStrobeWhite = scaleColor(White, Cfg::WarningStrobeWhiteScale);
+};
+
+static uint8_t triangleWave8(uint16_t step, uint16_t periodSteps) {
+  if (periodSteps < 2) {
+    return 255;
+  }
+
+  const uint16_t p = step % periodSteps;
+  const uint16_t half = periodSteps / 2;
+  if (p <= half) {
+    return (uint8_t)((uint32_t)p * 255 / half);
+  }
+  return (uint8_t)((uint32_t)(periodSteps - p) * 255 / half);
+}
+
+static uint32_t wheel(PixelStrip &s, uint8_t wheelPos) {
+  wheelPos = (uint8_t)(255 - wheelPos);
+  if (wheelPos < 85) {
+    return s.Color(255 - wheelPos * 3, 0, wheelPos * 3);
+  }
+  if (wheelPos < 170) {
+    wheelPos = (uint8_t)(wheelPos - 85);
+    return s.Color(0, wheelPos * 3, 255 - wheelPos * 3);
+  }
+  wheelPos = (uint8_t)(wheelPos - 170);
+  return s.Color(wheelPos * 3, 255 - wheelPos * 3, 0);
+}
+
+// Animation state with its timestamps expressed as "ms ago", so it can be
+// copied between units whose clocks differ (see phase_sync.h).
+struct AnimationSnapshot {
+  static constexpr uint16_t NotStarted = 0xFFFF;
+  static constexpr uint8_t PowerStates = 3; // powerState is below this
+
+  LedMode mode;
+  uint8_t powerState;
+  uint8_t activeCyclesDone;
+  uint8_t phase;
+  uint16_t step;
+  uint16_t sinceTickMs;       // NotStarted = no tick since restartAnimation()
+  uint16_t sincePowerStateMs; // NotStarted = power cycle not started yet
+};
+
+// Power-saving loop settings that can change at runtime (battery tiers, see
+// battery.h). Danger ignores them: it always runs at full brightness, no sleep.
+template <class Cfg> struct BasicPowerPolicy {
+  uint8_t brightness = Cfg::StripBrightness;
+  uint32_t sleepMs = Cfg::SleepMs;
+  uint8_t maxActiveCycles = 0xFF; // caps activeCyclesTarget()
+};
+typedef BasicPowerPolicy<Config> PowerPolicy;
+
+// The ring for one configuration type (config.h); LedRingController is the
+// build's own.
+template <class Cfg> class BasicLedRingController {
+public:
+  typedef PixelStripFor<Cfg> Strip;
+  typedef BasicPowerPolicy<Cfg> PowerPolicy;
+
+  static_assert(Cfg::CrossfadeFrameMs < Cfg::DangerChaseStepMs,
+                "a crossfade must resend faster than the quickest animation step");
+
+  explicit BasicLedRingController(Strip &s) : strip(s) {}
+
+  void begin() {
+    strip.begin();
+    strip.setBrightness(Cfg::StripBrightness);
+    strip.clear();
+    strip.show();
+  }
+
+  LedMode mode() const { return currentMode; }
+
+  // Takes effect from the next frame; a sleep already under way uses the new
+  // length.
+  void setPowerPolicy(const PowerPolicy &p) { policy = p; }
+  const PowerPolicy &powerPolicy() const { return policy; }
+
+  // Frames sent to the ring so far (wraps); tells a caller whether anything
+  // has been drawn since it last looked.
+  uint16_t framesShown() const { return shows; }
+
+  // 0 = Active, 1 = FadingOut, 2 = Sleeping (same as AnimationSnapshot::powerState).
+  uint8_t powerStateValue() const { return static_cast<uint8_t>(powerState); }
+
+  void setMode(LedMode newMode, bool forceRestart = false) {
+    if (!forceRestart && newMode == currentMode) {
+      return;
+    }
+
+    startCrossfade(newMode);
+    currentMode = newMode;
+    restartAnimation();
+    resetPowerCycle();
+    applyDither();
+  }
+
+  // Global switch on top of the per-mode Cfg::Dither* settings.
+  void setDitherEnabled(bool on) {
+    ditherEnabled = on;
+    applyDither();
+  }
+
+  // Global switch on top of Cfg::ModeCrossfadeMs; off cuts hard between
+  // modes. A crossfade already running finishes.
+  void setCrossfadeEnabled(bool on) { crossfadeEnabled = on; }
+
+  // True while a mode change is still being blended in.
+  bool crossfading() const { return fading; }
+
+  AnimationSnapshot snapshot(uint32_t nowMs) const {
+    AnimationSnapshot snap;
+    snap.mode = currentMode;
+    snap.powerState = static_cast<uint8_t>(powerState);
+    snap.activeCyclesDone = activeCyclesDone;
+    snap.phase = phase;
+    snap.step = step;
+    snap.sinceTickMs = msAgo(lastTickMs, nowMs);
+    snap.sincePowerStateMs = msAgo(powerStateStartMs, nowMs);
+    return snap;
+  }
+
+  // Jump to another unit's animation state. Nothing is redrawn until the next
+  // step is due, exactly as if this unit had been running in lockstep.
+  void applySnapshot(const AnimationSnapshot &snap, uint32_t nowMs) {
+    if (snap.mode != currentMode) {
+      startCrossfade(snap.mode);
+    }
+    currentMode = snap.mode;
+    powerState = static_cast<PowerState>(snap.powerState);
+    activeCyclesDone = snap.activeCyclesDone;
+    phase = snap.phase;
+    step = snap.step;
+    lastTickMs = (snap.sinceTickMs == AnimationSnapshot::NotStarted) ? 0 : nowMs - snap.sinceTickMs;
+    powerStateStartMs =
+        (snap.sincePowerStateMs == AnimationSnapshot::NotStarted) ? 0 : nowMs - snap.sincePowerStateMs;
+    powerOffCleared = false;
+    idleCleared = false;
+    applyDither();
+  }
+
+  void restartAnimation() {
+    phase = 0;
+    step = 0;
+    lastTickMs = 0;
+    idleCleared = false;
+  }
+
+  void resetPowerCycle() {
+    powerState = PowerState::Active;
+    activeCyclesDone = 0;
+    powerStateStartMs = 0;
+    powerOffCleared = false;
+    strip.setBrightness(policy.brightness);
+  }
+
+  void update(uint32_t nowMs) {
+    const bool wasFading = fading;
+    stepCrossfade(nowMs);
+    updateFrame(nowMs);
+
+    // Dithering only averages out while frames keep coming, so resend the
+    // current one if the animation hasn't shown anything for DitherFrameMs.
+    // A crossfade resends every CrossfadeFrameMs, in any mode, and once more
+    // unblended when it ends.
+    if (shownThisPass) {
+      shownThisPass = false;
+      lastShowMs = nowMs;
+    } else if ((fading && nowMs - lastShowMs >= Cfg::CrossfadeFrameMs) || (wasFading && !fading) ||
+               (dithering && currentMode != LedMode::Idle && powerState != PowerState::Sleeping &&
+                nowMs - lastShowMs >= Cfg::DitherFrameMs)) {
+      show();
+      shownThisPass = false;
+      lastShowMs = nowMs;
+    }
+  }
+
+private:
+  void updateFrame(uint32_t nowMs) {
+    // Danger stays on continuously (no power-saving loop).
+    if (currentMode == LedMode::Danger) {
+      strip.setBrightness(baseBrightness);
+      updateDanger(nowMs);
+      return;
+    }
+
+    // Idle is already off.
+    if (currentMode == LedMode::Idle) {
+      strip.setBrightness(policy.brightness);
+      updateIdle();
+      return;
+    }
+
+    if (powerStateStartMs == 0) {
+      powerStateStartMs = nowMs;
+    }
+
+    switch (powerState) {
+      case PowerState::Sleeping: {
+        if (!powerOffCleared) {
+          strip.setBrightness(policy.brightness);
+          strip.clear();
+          show();
+          powerOffCleared = true;
+        }
+
+        if (nowMs - powerStateStartMs >= policy.sleepMs) {
+          powerState = PowerState::Active;
+          powerStateStartMs = nowMs;
+          powerOffCleared = false;
+          strip.setBrightness(policy.brightness);
+          activeCyclesDone = 0;
+          restartAnimation();
+        }
+        return;
+      }
+
+      case PowerState::FadingOut: {
+        const uint32_t elapsed = nowMs - powerStateStartMs;
+        if (elapsed >= kFadeMs) {
+          strip.setBrightness(policy.brightness);
+          strip.clear();
+          show();
+
+          powerState = PowerState::Sleeping;
+          powerStateStartMs = nowMs;
+          powerOffCleared = true;
+          return;
+        }
+
+        // In 1/256 brightness steps; dithering shows the in-between levels.
+        const uint16_t remaining = (uint16_t)(kFadeMs - elapsed);
+        setStripLevel(strip, (uint16_t)((uint32_t)policy.brightness * 256 * remaining / kFadeMs));
+        show();
+        return;
+      }
+
+      case PowerState::Active:
+      default: {
+        strip.setBrightness(policy.brightness);
+
+        bool cycleDone = false;
+        switch (currentMode) {
+          case LedMode::Peace:
+            cycleDone = updatePeace(nowMs);
+            break;
+          case LedMode::Warning:
+            cycleDone = updateWarning(nowMs);
+            break;
+          case LedMode::SolidGreen:
+            cycleDone = updateSolidColor(nowMs, Palette::Green);
+            break;
+          case LedMode::SolidYellow:
+            cycleDone = updateSolidColor(nowMs, Palette::Yellow);
+            break;
+          case LedMode::SolidRed:
+            cycleDone = updateSolidColor(nowMs, Palette::Red);
+            break;
+          default:
+            // Should not happen (Idle/Danger handled above)
+            break;
+        }
+
+        if (cycleDone) {
+          activeCyclesDone++;
+          if (activeCyclesDone >= activeCyclesTarget()) {
+            powerState = PowerState::FadingOut;
+            powerStateStartMs = nowMs;
+          } else {
+            restartAnimation();
+          }
+        }
+        return;
+      }
+    }
+  }
+
+  typedef PaletteFor<Cfg> Palette;
+  typedef Geometry::Ring<Cfg> Ring;
+
+  Strip &strip;
+  LedMode currentMode = LedMode::Idle;
+
+  enum class PowerState : uint8_t {
+    Active = 0,
+    FadingOut = 1,
+    Sleeping = 2,
+  };
+  static_assert(static_cast<uint8_t>(PowerState::Sleeping) + 1 == AnimationSnapshot::PowerStates,
+                "AnimationSnapshot::PowerStates must count PowerState");
+
+  static constexpr uint32_t kFadeMs = Cfg::FadeMs;
+  static constexpr uint8_t baseBrightness = Cfg::StripBrightness;
+
+  uint8_t activeCyclesTarget() const {
+    uint8_t target = Cfg::ActiveCycles;
+    switch (currentMode) {
+      case LedMode::Peace:
+        target = Cfg::ActiveCyclesPeace;
+        break;
+      case LedMode::Warning:
+        target = Cfg::ActiveCyclesWarning;
+        break;
+      case LedMode::SolidGreen:
+      case LedMode::SolidYellow:
+      case LedMode::SolidRed:
+        target = Cfg::ActiveCyclesSolid;
+        break;
+      default:
+        target = Cfg::ActiveCycles;
+        break;
+    }
+
+    if (target > policy.maxActiveCycles) {
+      target = policy.maxActiveCycles;
+    }
+
+    // Avoid a "0 cycles" configuration that would immediately fade out.
+    return (target == 0) ? 1 : target;
+  }
+
+  bool ditherForMode() const {
+    switch (currentMode) {
+      case LedMode::Peace:
+        return Cfg::DitherPeace;
+      case LedMode::Warning:
+        return Cfg::DitherWarning;
+      case LedMode::Danger:
+        return Cfg::DitherDanger;
+      case LedMode::SolidGreen:
+      case LedMode::SolidYellow:
+      case LedMode::SolidRed:
+        return Cfg::DitherSolid;
+      default:
+        return false;
+    }
+  }
+
+  void applyDither() {
+    dithering = ditherEnabled && ditherForMode();
+    setStripDither(strip, dithering);
+  }
+
+  // Called before currentMode changes: hold what the ring shows now and fade
+  // the new mode in over it, from the next update().
+  void startCrossfade(LedMode to) {
+    if (Cfg::ModeCrossfadeMs == 0 || !crossfadeEnabled ||
+        (to == LedMode::Danger && !Cfg::CrossfadeIntoDanger)) {
+      fading = false;
+      releaseStripFrame(strip);
+      return;
+    }
+    holdStripFrame(strip);
+    fading = true;
+    fadeStartMs = 0;
+  }
+
+  void stepCrossfade(uint32_t nowMs) {
+    if (!fading) {
+      return;
+    }
+    if (fadeStartMs == 0) {
+      fadeStartMs = nowMs;
+    }
+    const uint32_t elapsed = nowMs - fadeStartMs;
+    if (elapsed >= Cfg::ModeCrossfadeMs) {
+      fading = false;
+      releaseStripFrame(strip);
+      return;
+    }
+    setStripMix(strip, (uint8_t)(elapsed * 256 / Cfg::ModeCrossfadeMs));
+  }
+
+  PowerPolicy policy;
+  PowerState powerState = PowerState::Active;
+  uint8_t activeCyclesDone = 0;
+  uint32_t powerStateStartMs = 0;
+  bool powerOffCleared = false;
+
+  // Shared animation state
+  uint8_t phase = 0;
+  uint16_t step = 0;
+  uint32_t lastTickMs = 0;
+  bool idleCleared = false;
+
+  bool ditherEnabled = true;
+  bool dithering = false;
+  bool crossfadeEnabled = true;
+  bool fading = false;
+  uint32_t fadeStartMs = 0; // 0 = starts at the next update()
+  bool shownThisPass = false;
+  uint32_t lastShowMs = 0;
+  uint16_t shows = 0;
+
+  // 0 is the "not started" marker for lastTickMs / powerStateStartMs.
+  static uint16_t msAgo(uint32_t thenMs, uint32_t nowMs) {
+    if (thenMs == 0) {
+      return AnimationSnapshot::NotStarted;
+    }
+    const uint32_t ago = nowMs - thenMs;
+    return (ago >= AnimationSnapshot::NotStarted) ? (uint16_t)(AnimationSnapshot::NotStarted - 1) : (uint16_t)ago;
+  }
+
+  void show() {
+    strip.show();
+    shownThisPass = true;
+    shows++;
+  }
+
+  void setAll(uint32_t color) {
+    for (uint16_t i = 0; i < Cfg::PixelCount; i++) {
+      strip.setPixelColor(i, color);
+    }
+  }
+
+  void chaseSingle(uint32_t color, uint8_t pos) {
+    strip.clear();
+    strip.setPixelColor(pos % Cfg::PixelCount, color);
+  }
+
+  // Sweep: `width` pixel pitches lit clockwise from slot headPos, where slot 0
+  // starts at 12 o'clock however the ring is mounted, over `background`.
+  void chaseSegment(uint32_t color, uint8_t headPos, uint8_t width, uint32_t background = 0) {
+    const uint8_t from = Ring::slotAngle(headPos);
+    for (uint16_t i = 0; i < Cfg::PixelCount; i++) {
+      strip.setPixelColor(i, Ring::inSweep(i, from, width) ? color : background);
+    }
+  }
+
+  // Dog's left half one color, right half the other; swap exchanges them.
+  void splitLeftRight(uint32_t left, uint32_t right, bool swap) {
+    for (uint16_t i = 0; i < Cfg::PixelCount; i++) {
+      strip.setPixelColor(i, (Ring::onDogsLeft(i) ^ swap) ? left : right);
+    }
+  }
+
+  void updateIdle() {
+    if (idleCleared) {
+      return;
+    }
+    strip.clear();
+    show();
+    idleCleared = true;
+  }
+
+  bool updateSolidColor(uint32_t nowMs, uint32_t color) {
+    // One cycle = show solid color briefly.
+    if (phase == 0) {
+      setAll(color);
+      show();
+      phase = 1;
+      lastTickMs = nowMs;
+      return false;
+    }
+
+    if (nowMs - lastTickMs < Cfg::SolidHoldMs) {
+      return false;
+    }
+
+    return true;
+  }
+
+  // Mode 2: Peace - multiple phases, all green-focused.
+  bool updatePeace(uint32_t nowMs) {
+    // phase 0: calm green chase over dim green background
+    if (phase == 0) {
+      if (nowMs - lastTickMs < Cfg::PeaceChaseStepMs) {
+        return false;
+      }
+      lastTickMs = nowMs;
+
+      chaseSegment(Palette::Green, (uint8_t)(step % Cfg::PixelCount), Cfg::PeaceChaseWidth,
+                   Palette::PeaceBackground);
+      show();
+
+      step++;
+      if (step >= Cfg::PeaceChaseSteps) {
+        phase = 1;
+        step = 0;
+        lastTickMs = nowMs;
+      }
+      return false;
+    }
+
+    // phase 1: green "breathing" pulse
+    if (phase == 1) {
+      if (nowMs - lastTickMs < Cfg::PeacePulseStepMs) {
+        return false;
+      }
+      lastTickMs = nowMs;
+
+      const uint8_t wave = triangleWave8(step, Cfg::PeacePulseSteps);
+      const uint16_t span = (uint16_t)(Cfg::PeacePulseMaxScale - Cfg::PeacePulseMinScale);
+      const uint8_t intensity = (uint8_t)(Cfg::PeacePulseMinScale + (uint32_t)span * wave / 255);
+      setAll(scaleColor(Palette::Green, intensity));
+      show();
+
+      step++;
+      if (step >= Cfg::PeacePulseSteps) {
+        phase = 2;
+        step = 0;
+        lastTickMs = nowMs;
+      }
+      return false;
+    }
+
+    // phase 2: soft sparkles (bright green points over dim green)
+    if (phase == 2) {
+      if (nowMs - lastTickMs < Cfg::PeaceSparkleStepMs) {
+        return false;
+      }
+      lastTickMs = nowMs;
+
+      setAll(Palette::PeaceBackground);
+      for (uint8_t j = 0; j < Cfg::PeaceSparkleCount; j++) {
+        const uint8_t idx = (uint8_t)((step * 3u + j * 5u) % Cfg::PixelCount);
+        // Mostly green sparkles, with occasional blue/cyan/purple "sprinkles".
+        const uint8_t sel = (uint8_t)((step + j * 3u) % 12u);
+        uint32_t c = Palette::PeaceSparkle;
+        if (sel == 0) {
+          c = Palette::PeaceSprinkleCyan;
+        } else if (sel == 1) {
+          c = Palette::PeaceSprinklePurple;
+        } else if (sel == 2) {
+          c = Palette::PeaceSprinkleBlue;
+        }
+        strip.setPixelColor(idx, c);
+      }
+      show();
+
+      step++;
+      if (step >= Cfg::PeaceSparkleSteps) {
+        phase = 3;
+        step = 0;
+        lastTickMs = nowMs;
+      }
+      return false;
+    }
+
+    // phase 3: brief solid green hold, then complete cycle
+    if (phase == 3) {
+      if (step == 0) {
+        setAll(Palette::Green);
+        show();
+        step = 1;
+        lastTickMs = nowMs;
+        return false;
+      }
+
+      if (nowMs - lastTickMs < Cfg::PeaceHoldMs) {
+        return false;
+      }
+
+      return true;
+    }
+
+    return false;
+  }
+
+  // Mode 3: Warning (moved from former De-escalate)
+  // Warning-y yellow hazard chase with occasional white strobes.
+  bool updateWarning(uint32_t nowMs) {
+    // phase 0: yellow "hazard" chase around the ring
+    if (phase == 0) {
+      const uint16_t stepsTotal = (uint16_t)(Cfg::WarningChaseLaps * Cfg::PixelCount);
+      if (nowMs - lastTickMs < Cfg::WarningChaseStepMs) {
+        return false;
+      }
+      lastTickMs = nowMs;
+
+      chaseSegment(Palette::Yellow, (uint8_t)(step % Cfg::PixelCount), Cfg::WarningChaseWidth);
+      show();
+
+      step++;
+      if (step >= stepsTotal) {
+        phase = 1;
+        step = 0;
+        lastTickMs = nowMs;
+      }
+      return false;
+    }
+
+    // phase 1: brief white strobes alternating with yellow for drama
+    if (phase == 1) {
+      if (nowMs - lastTickMs < Cfg::WarningStrobeStepMs) {
+        return false;
+      }
+      lastTickMs = nowMs;
+
+      // "Police light" style: split the ring into left and right halves. One
+      // half is solid yellow, the other the dimmed white strobe. Swap sides
+      // each step.
+      splitLeftRight(Palette::WarningStrobeWhite, Palette::Yellow, (step % 2) == 1);
+      show();
+
+      step++;
+      if (step >= Cfg::WarningStrobeSteps) {
+        return true;
+      }
+      return false;
+    }
+
+    return true;
+  }
+
+  // Mode 4: red chase, then fast flash/pulse, then cop-lights (4 red, 4 blue) alternating.
+  void updateDanger(uint32_t nowMs) {
+    // phase 0: fast red chase
+    if (phase == 0) {
+      const uint16_t stepsTotal = (uint16_t)(Cfg::DangerChaseLaps * Cfg::PixelCount);
+      if (nowMs - lastTickMs < Cfg::DangerChaseStepMs) {
+        return;
+      }
+      lastTickMs = nowMs;
+
+      chaseSegment(Palette::Red, (uint8_t)(step % Cfg::PixelCount), Cfg::DangerChaseWidth);
+      show();
+
+      step++;
+      if (step >= stepsTotal) {
+        phase = 1;
+        step = 0;
+        lastTickMs = nowMs;
+      }
+      return;
+    }
+
+    // phase 1: flash/pulse red quickly
+    if (phase == 1) {
+      if (nowMs - lastTickMs < Cfg::DangerPulseStepMs) {
+        return;
+      }
+      lastTickMs = nowMs;
+
+      const bool flash = (step % Cfg::DangerFlashEvery) == 0;
+      const uint8_t intensity =
+          flash ? 255 : (uint8_t)(Cfg::DangerPulseBase + triangleWave8(step, Cfg::DangerPulseTrianglePeriod) / 2);
+      setAll(scaleColor(Palette::Red, intensity));
+      show();
+
+      step++;
+      if (step >= Cfg::DangerPulseSteps) {
+        phase = 2;
+        step = 0;
+        lastTickMs = nowMs;
+      }
+      return;
+    }
+
+    // phase 2: "cop lights", dog's left and right halves alternating red/blue
+    if (nowMs - lastTickMs < Cfg::DangerCopStepMs) {
+      return;
+    }
+    lastTickMs = nowMs;
+
+    splitLeftRight(Palette::Red, Palette::Blue, (step % 2) == 1);
+    show();
+
+    step++;
+    if (step >= Cfg::DangerCopSteps) {
+      phase = 0;
+      step = 0;
+      lastTickMs = nowMs;
+    }
+  }
+};
+
+typedef BasicLedRingController<Config> LedRingController;
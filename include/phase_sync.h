@@ -0,0 +1,302 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "config.h"
+#include "led_ring.h"
+
+// ----------------------------
+// Multi-collar phase sync
+// ----------------------------
+// The leader periodically broadcasts a beacon: its animation clock plus an
+// AnimationSnapshot of its LedRingController. Each follower runs its
+// controller on an AnimationClock that it slews toward the leader's clock,
+// and copies the leader's animation state whenever the two have drifted
+// further apart than Config::SyncToleranceMs (or are in different modes).
+//
+// Per frame the only cost is AnimationClock::update(): a few adds. Beacon
+// handling (one 32-bit divide) happens once per Config::SyncBeaconMs.
+namespace Sync {
+
+// Wire format, little-endian, 17 bytes:
+//   0xA5 0x5A | animMs u32 | mode | powerState | activeCyclesDone | phase |
+//   step u16 | sinceTickMs u16 | sincePowerStateMs u16 | check
+static constexpr uint8_t kFrameStart0 = 0xA5;
+static constexpr uint8_t kFrameStart1 = 0x5A;
+static constexpr uint8_t kPayloadBytes = 14;
+static constexpr uint8_t kFrameBytes = 2 + kPayloadBytes + 1;
+
+// Time from the leader stamping a beacon to the follower holding all of it.
+static constexpr uint16_t kLinkLatencyMs =
+    (uint16_t)(((uint32_t)kFrameBytes * 10u * 1000u + Config::SyncBaud / 2) / Config::SyncBaud);
+
+struct Beacon {
+  uint32_t animMs;
+  AnimationSnapshot snap;
+};
+
+inline uint8_t checkByte(const uint8_t *payload) {
+  uint8_t c = kFrameStart1;
+  for (uint8_t i = 0; i < kPayloadBytes; i++) {
+    c = (uint8_t)(((c << 1) | (c >> 7)) ^ payload[i]);
+  }
+  return c;
+}
+
+inline void encode(const Beacon &b, uint8_t (&out)[kFrameBytes]) {
+  uint8_t *p = &out[2];
+  out[0] = kFrameStart0;
+  out[1] = kFrameStart1;
+  p[0] = (uint8_t)b.animMs;
+  p[1] = (uint8_t)(b.animMs >> 8);
+  p[2] = (uint8_t)(b.animMs >> 16);
+  p[3] = (uint8_t)(b.animMs >> 24);
+  p[4] = static_cast<uint8_t>(b.snap.mode);
+  p[5] = b.snap.powerState;
+  p[6] = b.snap.activeCyclesDone;
+  p[7] = b.snap.phase;
+  p[8] = (uint8_t)b.snap.step;
+  p[9] = (uint8_t)(b.snap.step >> 8);
+  p[10] = (uint8_t)b.snap.sinceTickMs;
+  p[11] = (uint8_t)(b.snap.sinceTickMs >> 8);
+  p[12] = (uint8_t)b.snap.sincePowerStateMs;
+  p[13] = (uint8_t)(b.snap.sincePowerStateMs >> 8);
+  out[kFrameBytes - 1] = checkByte(p);
+}
+
+// Byte-at-a-time frame decoder. Resynchronizes on the start marker after
+// noise or a bad check byte.
+class BeaconParser {
+public:
+  // Returns true when b completes a valid beacon (written to out).
+  bool push(uint8_t b, Beacon &out) {
+    if (fill == 0) {
+      fill = (b == kFrameStart0) ? 1 : 0;
+      return false;
+    }
+    if (fill == 1) {
+      fill = (b == kFrameStart1) ? 2 : ((b == kFrameStart0) ? 1 : 0);
+      return false;
+    }
+
+    payload[fill - 2] = b;
+    fill++;
+    if (fill < kFrameBytes) {
+      return false;
+    }
+    fill = 0;
+    const uint8_t *p = payload;
+    // The check byte is weak; never let a mode or power state outside its
+    // enum through to the ring.
+    if (b != checkByte(payload) || p[4] < static_cast<uint8_t>(LedMode::Idle) ||
+        p[4] > static_cast<uint8_t>(LedMode::SolidRed) || p[5] >= AnimationSnapshot::PowerStates) {
+      rejected++;
+      return false;
+    }
+
+    out.animMs = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+    out.snap.mode = static_cast<LedMode>(p[4]);
+    out.snap.powerState = p[5];
+    out.snap.activeCyclesDone = p[6];
+    out.snap.phase = p[7];
+    out.snap.step = (uint16_t)(p[8] | (p[9] << 8));
+    out.snap.sinceTickMs = (uint16_t)(p[10] | (p[11] << 8));
+    out.snap.sincePowerStateMs = (uint16_t)(p[12] | (p[13] << 8));
+    return true;
+  }
+
+  uint16_t rejectedFrames() const { return rejected; }
+
+private:
+  // payload also holds the check byte in its last slot
+  uint8_t payload[kPayloadBytes + 1];
+  uint8_t fill = 0;
+  uint16_t rejected = 0;
+};
+
+// Local millis() -> animation time, with a rate trim and gradual (slewed)
+// phase correction in 1/65536 ms fixed point. Never runs backwards while
+// slewing; errors beyond Config::SyncStepThresholdMs jump.
+class AnimationClock {
+public:
+  static constexpr int32_t kMaxSlewQ16PerMs = 65536 / 16; // run at most 6.25% fast/slow
+  static constexpr int32_t kMaxRateQ16 = 65536 / 50;      // +-2% crystal error
+
+  uint32_t update(uint32_t localMs) {
+    uint32_t dt = localMs - lastLocalMs;
+    lastLocalMs = localMs;
+
+    // Long gaps (first call, debugger) advance 1:1.
+    if (dt > 1000) {
+      animMs += dt - 1000;
+      dt = 1000;
+    }
+
+    int32_t delta = (int32_t)dt * (65536 + rateQ16);
+    const int32_t maxSlew = (int32_t)dt * kMaxSlewQ16PerMs;
+    int32_t slew = pendingQ16;
+    if (slew > maxSlew) {
+      slew = maxSlew;
+    } else if (slew < -maxSlew) {
+      slew = -maxSlew;
+    }
+    pendingQ16 -= slew;
+    delta += slew;
+    if (delta < 0) {
+      delta = 0;
+    }
+
+    const uint32_t acc = fracQ16 + (uint32_t)delta;
+    animMs += acc >> 16;
+    fracQ16 = (uint16_t)acc;
+    return animMs;
+  }
+
+  uint32_t now() const { return animMs; }
+
+  // The leader's clock reads leaderMs at local time localMs. Returns the
+  // error (leader - us) in ms before correction.
+  int32_t correct(uint32_t localMs, uint32_t leaderMs) {
+    update(localMs);
+    const int32_t errMs = (int32_t)(leaderMs - animMs);
+
+    if (!locked || errMs > (int32_t)Config::SyncStepThresholdMs || errMs < -(int32_t)Config::SyncStepThresholdMs) {
+      animMs = leaderMs;
+      fracQ16 = 0;
+      pendingQ16 = 0;
+      locked = true;
+      lastCorrectLocalMs = localMs;
+      return errMs;
+    }
+
+    // Whatever error is left after the previous slew completed is mostly
+    // rate mismatch: fold a quarter of it into the trim.
+    const uint32_t intervalMs = localMs - lastCorrectLocalMs;
+    lastCorrectLocalMs = localMs;
+    if (intervalMs != 0 && intervalMs < 0x8000u) {
+      rateQ16 += (errMs * 65536L) / (int32_t)intervalMs / 4;
+      if (rateQ16 > kMaxRateQ16) {
+        rateQ16 = kMaxRateQ16;
+      } else if (rateQ16 < -kMaxRateQ16) {
+        rateQ16 = -kMaxRateQ16;
+      }
+    }
+    pendingQ16 = errMs * 65536L;
+    return errMs;
+  }
+
+  bool isLocked() const { return locked; }
+  int32_t rateTrimQ16() const { return rateQ16; }
+
+private:
+  uint32_t lastLocalMs = 0;
+  uint32_t animMs = 0;
+  uint16_t fracQ16 = 0;
+  int32_t rateQ16 = 0;
+  int32_t pendingQ16 = 0;
+  uint32_t lastCorrectLocalMs = 0;
+  bool locked = false;
+};
+
+// Snapshot times are "ms ago" as of when the beacon was stamped.
+inline uint16_t agedMs(uint16_t sinceMs, uint16_t byMs) {
+  if (sinceMs == AnimationSnapshot::NotStarted) {
+    return sinceMs;
+  }
+  const uint32_t aged = (uint32_t)sinceMs + byMs;
+  return (aged >= AnimationSnapshot::NotStarted) ? (uint16_t)(AnimationSnapshot::NotStarted - 1) : (uint16_t)aged;
+}
+
+inline bool withinTolerance(uint16_t a, uint16_t b) {
+  if (a == AnimationSnapshot::NotStarted || b == AnimationSnapshot::NotStarted) {
+    return a == b;
+  }
+  const uint16_t diff = (a > b) ? (uint16_t)(a - b) : (uint16_t)(b - a);
+  return diff <= Config::SyncToleranceMs;
+}
+
+// True if the follower (f) and leader (l) snapshots, taken at the same
+// animation time, show the same frame within tolerance. A unit that is one
+// step ahead counts as in sync if it took that step within the tolerance.
+inline bool inSync(const AnimationSnapshot &f, const AnimationSnapshot &l) {
+  if (f.mode != l.mode || f.powerState != l.powerState || f.activeCyclesDone != l.activeCyclesDone ||
+      f.phase != l.phase) {
+    return false;
+  }
+  if (f.mode == LedMode::Idle) {
+    return true;
+  }
+  if (f.step == l.step) {
+    return withinTolerance(f.sinceTickMs, l.sinceTickMs) && withinTolerance(f.sincePowerStateMs, l.sincePowerStateMs);
+  }
+  if (f.step == (uint16_t)(l.step + 1)) {
+    return f.sinceTickMs <= Config::SyncToleranceMs;
+  }
+  if (l.step == (uint16_t)(f.step + 1)) {
+    return l.sinceTickMs <= Config::SyncToleranceMs;
+  }
+  return false;
+}
+
+class Leader {
+public:
+  uint32_t animNow(uint32_t localMs) { return clock.update(localMs); }
+
+  // Beacon for "now"; due when the interval elapsed or the mode changed.
+  bool due(uint32_t localMs, LedMode mode) const {
+    return !sentAny || mode != lastMode || (uint32_t)(localMs - lastSentMs) >= Config::SyncBeaconMs;
+  }
+
+  Beacon makeBeacon(uint32_t localMs, const LedRingController &ring) {
+    Beacon b;
+    b.animMs = clock.update(localMs);
+    b.snap = ring.snapshot(b.animMs);
+    sentAny = true;
+    lastSentMs = localMs;
+    lastMode = b.snap.mode;
+    return b;
+  }
+
+private:
+  AnimationClock clock;
+  uint32_t lastSentMs = 0;
+  LedMode lastMode = LedMode::Idle;
+  bool sentAny = false;
+};
+
+class Follower {
+public:
+  uint32_t animNow(uint32_t localMs) { return clock.update(localMs); }
+
+  // Handle a beacon that finished arriving at local time localMs. Returns
+  // true if the controller's animation state was replaced.
+  bool onBeacon(const Beacon &b, uint32_t localMs, LedRingController &ring) {
+    lastErr = clock.correct(localMs, b.animMs + kLinkLatencyMs);
+    beacons++;
+
+    AnimationSnapshot leader = b.snap;
+    leader.sinceTickMs = agedMs(leader.sinceTickMs, kLinkLatencyMs);
+    leader.sincePowerStateMs = agedMs(leader.sincePowerStateMs, kLinkLatencyMs);
+
+    const uint32_t nowMs = clock.now();
+    if (inSync(ring.snapshot(nowMs), leader)) {
+      return false;
+    }
+    ring.applySnapshot(leader, nowMs);
+    resyncs++;
+    return true;
+  }
+
+  int32_t lastErrorMs() const { return lastErr; }
+  uint32_t beaconCount() const { return beacons; }
+  uint32_t resyncCount() const { return resyncs; }
+  const AnimationClock &animationClock() const { return clock; }
+
+private:
+  AnimationClock clock;
+  int32_t lastErr = 0;
+  uint32_t beacons = 0;
+  uint32_t resyncs = 0;
+};
+
+} // namespace Sync
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "config.h"
+
+// ----------------------------
+// Ring geometry
+// ----------------------------
+// Where each pixel physically sits, so effects can be written in directions
+// (a sweep from 12 o'clock, the dog's left half) instead of pixel indices, and
+// still hold for another PixelCount or RingRotation. Ring<Cfg> takes both from
+// a configuration type (config.h). The table is computed by the compiler and
+// lives in flash, 3 bytes per pixel; nothing here does trigonometry at runtime.
+//
+// Seen from the front, pixels are evenly spaced clockwise, LED1 half a pitch
+// right of 12 o'clock at RingRotation 0.
+//   angle: 1/256 turn, clockwise from 12 o'clock
+//   x, y:  -127..127, +x to the viewer's right (the dog's left, with the ring
+//          facing out from the front of the collar), +y up
+
+namespace Geometry {
+
+struct Pixel {
+  uint8_t angle;
+  int8_t x;
+  int8_t y;
+};
+
+// ---- compile time only ----
+
+// Taylor series; |r| <= pi, so 10 terms is far past 8-bit precision.
+constexpr double sinSeries(double r2, double term, double sum, uint8_t k) {
+  return (k == 10) ? sum : sinSeries(r2, -term * r2 / ((2.0 * k + 2) * (2.0 * k + 3)), sum + term, (uint8_t)(k + 1));
+}
+
+constexpr double sinRadians(double r) { return sinSeries(r * r, r, 0.0, 0); }
+
+// Angle in 1/256 turn, wrapped to -128..127 before converting.
+constexpr double sinTurn(uint8_t a) { return sinRadians((a < 128 ? a : a - 256.0) * 3.14159265358979 / 128); }
+
+constexpr int8_t toFixed(double v) { return (int8_t)(v * 127 + (v < 0 ? -0.5 : 0.5)); }
+
+constexpr uint8_t angleOf(uint16_t i, uint16_t count, uint8_t rotation) {
+  return (uint8_t)((uint32_t)(2 * i + 1) * 128 / count + rotation);
+}
+
+constexpr Pixel pixelAt(uint16_t i, uint16_t count, uint8_t rotation) {
+  return Pixel{angleOf(i, count, rotation), toFixed(sinTurn(angleOf(i, count, rotation))),
+               toFixed(sinTurn((uint8_t)(angleOf(i, count, rotation) + 64)))};
+}
+
+template <uint16_t... I> struct Indices {};
+template <uint16_t N, uint16_t... I> struct MakeIndices : MakeIndices<N - 1, N - 1, I...> {};
+template <uint16_t... I> struct MakeIndices<0, I...> {
+  typedef Indices<I...> type;
+};
+
+template <uint16_t Count, uint8_t Rotation, typename> struct Table;
+template <uint16_t Count, uint8_t Rotation, uint16_t... I> struct Table<Count, Rotation, Indices<I...>> {
+  static const Pixel pixels[sizeof...(I)] PROGMEM;
+};
+template <uint16_t Count, uint8_t Rotation, uint16_t... I>
+const Pixel Table<Count, Rotation, Indices<I...>>::pixels[sizeof...(I)] PROGMEM = {pixelAt(I, Count, Rotation)...};
+
+static_assert(pixelAt(0, 8, 0).angle == 16 && pixelAt(0, 8, 0).x == 49 && pixelAt(0, 8, 0).y == 117 &&
+                  pixelAt(5, 8, 0).x == -117,
+              "geometry table does not match the documented layout");
+
+// ---- runtime ----
+
+template <class Cfg> struct Ring {
+  static_assert(Cfg::PixelCount >= 2 && Cfg::PixelCount <= 128, "8-bit angles need 2 steps per pixel");
+
+  typedef Table<Cfg::PixelCount, Cfg::RingRotation, typename MakeIndices<Cfg::PixelCount>::type> Layout;
+
+  static uint8_t angle(uint16_t i) { return pgm_read_byte(&Layout::pixels[i].angle); }
+  static int8_t x(uint16_t i) { return (int8_t)pgm_read_byte(&Layout::pixels[i].x); }
+  static int8_t y(uint16_t i) { return (int8_t)pgm_read_byte(&Layout::pixels[i].y); }
+
+  // Halves split on the vertical axis; a pixel exactly at 12 or 6 o'clock goes
+  // with the side it leads into clockwise.
+  static bool onDogsLeft(uint16_t i) { return x(i) > 0 || (x(i) == 0 && angle(i) < 128); }
+
+  // Start of sweep slot `slot` (0..PixelCount-1): slot 0 begins at 12 o'clock.
+  static uint8_t slotAngle(uint8_t slot) { return (uint8_t)((uint16_t)slot * 256 / Cfg::PixelCount); }
+
+  // True if pixel i lies within `width` pixel pitches clockwise of `from`.
+  static bool inSweep(uint16_t i, uint8_t from, uint8_t width) {
+    return (uint16_t)(uint8_t)(angle(i) - from) * Cfg::PixelCount < (uint16_t)width * 256;
+  }
+};
+
+} // namespace Geometry
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <Arduino.h>
+
+// ----------------------------
+// Cooperative task scheduler
+// ----------------------------
+// Tasks are registered statically in a constexpr table ordered by priority
+// (0 = most urgent). Each runOnce() call runs exactly one task: the most urgent
+// one that is ready. A task is ready when its period has elapsed (periodic
+// tasks) or when it has been signal()ed (event-triggered tasks, periodMs = 0).
+//
+// Running one task per pass bounds how long an urgent task can wait to the
+// longest single run of any other task, so long-running work (serial parsing,
+// log output) must cap itself using TaskContext::expired() and return true to
+// be called again on a later pass.
+namespace Sched {
+
+struct TaskContext {
+  uint32_t nowMs;
+  uint32_t startUs;
+  uint16_t budgetUs;
+
+  bool expired() const { return (uint32_t)(micros() - startUs) >= budgetUs; }
+};
+
+// Returns true if the task has more work and wants to run again as soon as
+// nothing more urgent is ready.
+using TaskFn = bool (*)(const TaskContext &ctx);
+
+struct TaskSpec {
+  const char *name;
+  TaskFn fn;
+  uint8_t priority;
+  uint16_t periodMs; // 0 = only runs when signal()ed
+  uint16_t budgetUs; // runs longer than this are counted as overruns
+};
+
+struct TaskStats {
+  uint32_t runs;
+  uint32_t totalUs;
+  uint16_t maxUs;
+  uint16_t overruns;
+  uint16_t maxLateMs; // worst delay past the due time (periodic tasks)
+};
+
+// True if specs[i..n) are in strictly increasing priority order.
+constexpr bool prioritiesSorted(const TaskSpec *specs, uint8_t n, uint8_t i = 1) {
+  return (i >= n) ? true : (specs[i - 1].priority < specs[i].priority && prioritiesSorted(specs, n, (uint8_t)(i + 1)));
+}
+
+template <uint8_t N>
+class Scheduler {
+public:
+  explicit Scheduler(const TaskSpec (&specs)[N]) : specs(specs) {}
+
+  void begin(uint32_t nowMs) {
+    for (uint8_t i = 0; i < N; i++) {
+      state[i].lastRunMs = nowMs;
+      state[i].pending = false;
+      stats[i] = TaskStats();
+    }
+  }
+
+  // Mark an event-triggered task (or a periodic one, early) as ready.
+  void signal(uint8_t id) {
+    if (id < N) {
+      state[id].pending = true;
+    }
+  }
+
+  // Run the most urgent ready task. Returns false if nothing was ready.
+  bool runOnce(uint32_t nowMs) {
+    for (uint8_t i = 0; i < N; i++) {
+      const TaskSpec &spec = specs[i];
+      TaskState &st = state[i];
+
+      uint32_t lateMs = 0;
+      bool ready = st.pending;
+      if (!ready && spec.periodMs != 0) {
+        const uint32_t sinceMs = nowMs - st.lastRunMs;
+        if (sinceMs >= spec.periodMs) {
+          ready = true;
+          lateMs = sinceMs - spec.periodMs;
+        }
+      }
+      if (!ready) {
+        continue;
+      }
+
+      st.pending = false;
+      st.lastRunMs = nowMs;
+
+      const TaskContext ctx = {nowMs, micros(), spec.budgetUs};
+      const bool more = spec.fn(ctx);
+      const uint32_t tookUs = micros() - ctx.startUs;
+
+      TaskStats &s = stats[i];
+      s.runs++;
+      s.totalUs += tookUs;
+      if (tookUs > s.maxUs) {
+        s.maxUs = (tookUs > 0xFFFFu) ? 0xFFFFu : (uint16_t)tookUs;
+      }
+      if (tookUs > spec.budgetUs && s.overruns != 0xFFFFu) {
+        s.overruns++;
+      }
+      if (lateMs > s.maxLateMs) {
+        s.maxLateMs = (lateMs > 0xFFFFu) ? 0xFFFFu : (uint16_t)lateMs;
+      }
+
+      if (more) {
+        st.pending = true;
+      }
+      return true;
+    }
+    return false;
+  }
+
+  uint8_t count() const { return N; }
+  const TaskSpec &spec(uint8_t id) const { return specs[id]; }
+  const TaskStats &taskStats(uint8_t id) const { return stats[id]; }
+
+private:
+  struct TaskState {
+    uint32_t lastRunMs;
+    bool pending;
+  };
+
+  const TaskSpec (&specs)[N];
+  TaskState state[N] = {};
+  TaskStats stats[N] = {};
+};
+
+} // namespace Sched
@@ -0,0 +1,280 @@
+#pragma once
+
+#include <Arduino.h>
+
+// ----------------------------
+// WS2812 driver, pinned at compile time
+// ----------------------------
+// Drop-in for the subset of Adafruit_NeoPixel the firmware uses, without its
+// runtime costs:
+// - the pixel buffer is a member array (no malloc)
+// - pin -> port/bit is resolved at compile time (ATmega32U4 pin map below)
+// - the color order is a template parameter, so setPixelColor() is three
+//   stores at fixed offsets
+// - brightness is applied once per byte in show() instead of on every
+//   setPixelColor(), and the buffer keeps full-precision colors (Adafruit
+//   rescales its buffer in place, which is lossy)
+// - crossfades blend against one held frame in the same per-byte pass
+//
+// On AVR the output loop is hand-timed for 16 MHz / 800 kHz. Other targets
+// (the host simulation) hand the frame to ws2812HostShow().
+
+// Color orders, same encoding as Adafruit_NeoPixel (R/G/B byte offsets).
+#ifndef NEO_GRB
+#define NEO_RGB ((0 << 6) | (0 << 4) | (1 << 2) | (2))
+#define NEO_RBG ((0 << 6) | (0 << 4) | (2 << 2) | (1))
+#define NEO_GRB ((1 << 6) | (1 << 4) | (0 << 2) | (2))
+#define NEO_GBR ((2 << 6) | (2 << 4) | (0 << 2) | (1))
+#define NEO_BRG ((1 << 6) | (1 << 4) | (2 << 2) | (0))
+#define NEO_BGR ((2 << 6) | (2 << 4) | (1 << 2) | (0))
+#endif
+
+namespace Ws2812Pins {
+
+// ATmega32U4 (Leonardo / Pro Micro variant) Arduino pin -> port letter and
+// bit, mirroring the core's digital_pin_to_port/bit_mask tables. 0 = no pin.
+constexpr char portOf(uint8_t pin) {
+  return (pin <= 4) ? 'D'
+         : (pin == 5) ? 'C'
+         : (pin == 6) ? 'D'
+         : (pin == 7) ? 'E'
+         : (pin <= 11) ? 'B'
+         : (pin == 12) ? 'D'
+         : (pin == 13) ? 'C'
+         : (pin <= 17) ? 'B'
+         : (pin <= 23) ? 'F'
+         : (pin <= 25) ? 'D'
+         : (pin <= 28) ? 'B'
+         : (pin <= 30) ? 'D'
+                       : 0;
+}
+
+constexpr uint8_t bitOf(uint8_t pin) {
+  return (pin == 0) ? 2 : (pin == 1) ? 3 : (pin == 2) ? 1 : (pin == 3) ? 0 : (pin == 4) ? 4 : (pin == 5) ? 6
+       : (pin == 6) ? 7 : (pin == 7) ? 6 : (pin == 8) ? 4 : (pin == 9) ? 5 : (pin == 10) ? 6 : (pin == 11) ? 7
+       : (pin == 12) ? 6 : (pin == 13) ? 7 : (pin == 14) ? 3 : (pin == 15) ? 1 : (pin == 16) ? 2 : (pin == 17) ? 0
+       : (pin == 18) ? 7 : (pin == 19) ? 6 : (pin == 20) ? 5 : (pin == 21) ? 4 : (pin == 22) ? 1 : (pin == 23) ? 0
+       : (pin == 24) ? 4 : (pin == 25) ? 7 : (pin == 26) ? 4 : (pin == 27) ? 5 : (pin == 28) ? 6 : (pin == 29) ? 6
+       : 5;
+}
+
+// I/O-space addresses (for in/out/sbi/cbi) of the PORTx registers.
+constexpr uint8_t portIoAddr(char port) {
+  return (port == 'B') ? 0x05 : (port == 'C') ? 0x08 : (port == 'D') ? 0x0B : (port == 'E') ? 0x0E : 0x11;
+}
+
+} // namespace Ws2812Pins
+
+#if !defined(__AVR__)
+// Provided by the host simulation: post-brightness RGB, 3 bytes per pixel,
+// sent after waiting latchWaitUs (the rest of the driver's latch time).
+void ws2812HostShow(const uint8_t *rgb, uint16_t count, uint16_t latchWaitUs);
+#endif
+
+template <uint8_t Pin, uint16_t Count, uint8_t Order>
+class Ws2812 {
+public:
+  static_assert(Ws2812Pins::portOf(Pin) != 0, "Ws2812: pin has no port on ATmega32U4");
+  static_assert(((Order >> 6) & 3) == ((Order >> 4) & 3), "Ws2812: RGBW orders are not supported");
+  static_assert(Count > 0 && Count <= 255, "Ws2812: pixel count out of range");
+
+  void begin() {
+#if defined(__AVR__)
+    _SFR_IO8(kPortIo - 1) |= kMask; // DDRx sits just below PORTx
+    _SFR_IO8(kPortIo) &= (uint8_t)~kMask;
+#endif
+  }
+
+  void show() {
+#if defined(__AVR__)
+    // Hold the line low long enough to latch the previous frame.
+    while ((uint32_t)(micros() - endUs) < kLatchUs) {
+    }
+
+    uint8_t scaled[kBytes + 1]; // +1: the output loop prefetches one byte past the end
+    const uint8_t *out = raw;
+    if (level != kFullLevel || mixing) {
+      for (uint16_t i = 0; i < kBytes; i++) {
+        scaled[i] = outputByte(i, raw[i]);
+      }
+      out = scaled;
+    }
+    send(out);
+    endUs = micros();
+#else
+    uint8_t rgb[kBytes];
+    for (uint16_t i = 0; i < Count; i++) {
+      rgb[i * 3 + 0] = outputByte((uint16_t)(i * 3 + kR), raw[i * 3 + kR]);
+      rgb[i * 3 + 1] = outputByte((uint16_t)(i * 3 + kG), raw[i * 3 + kG]);
+      rgb[i * 3 + 2] = outputByte((uint16_t)(i * 3 + kB), raw[i * 3 + kB]);
+    }
+    // The same latch as above; the simulated clock only moves when told to.
+    const uint32_t sinceUs = micros() - endUs;
+    ws2812HostShow(rgb, Count, (uint16_t)(sinceUs < kLatchUs ? kLatchUs - sinceUs : 0));
+    endUs = micros();
+#endif
+  }
+
+  void clear() { memset(raw, 0, kBytes); }
+
+  uint16_t numPixels() const { return Count; }
+
+  void setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b) {
+    if (n >= Count) {
+      return;
+    }
+    uint8_t *p = &raw[n * 3];
+    p[kR] = r;
+    p[kG] = g;
+    p[kB] = b;
+  }
+
+  void setPixelColor(uint16_t n, uint32_t c) { setPixelColor(n, (uint8_t)(c >> 16), (uint8_t)(c >> 8), (uint8_t)c); }
+
+  uint32_t getPixelColor(uint16_t n) const {
+    if (n >= Count) {
+      return 0;
+    }
+    const uint8_t *p = &raw[n * 3];
+    return Color(p[kR], p[kG], p[kB]);
+  }
+
+  // 0-255, applied at show() time.
+  void setBrightness(uint8_t b) { level = (uint16_t)(b << 8); }
+  uint8_t getBrightness() const { return (uint8_t)(level >> 8); }
+
+  // Brightness in 8.8 fixed point (b << 8 is setBrightness(b)), for fades in
+  // finer steps than 1/255. Without dithering the fraction is mostly lost to
+  // the output step.
+  void setBrightnessFine(uint16_t l) { level = (l > kFullLevel) ? kFullLevel : l; }
+  uint16_t getBrightnessFine() const { return level; }
+
+  // Temporal dithering. Each channel is scaled to 8.8 fixed point and the
+  // fraction is carried into the same channel's next show(), so a level
+  // between two output steps comes out as the right mix of both over
+  // successive frames. It only reads as smooth if show() keeps being called at
+  // a few hundred Hz. Full brightness has no fraction and is sent unchanged.
+  void setDither(bool on) {
+    if (on && !dither) {
+      memset(residual, 0, kBytes);
+    }
+    dither = on;
+  }
+  bool getDither() const { return dither; }
+
+  // Crossfade. holdFrame() keeps what the LEDs show now (post-brightness, or
+  // the blend if a crossfade is already running); until releaseFrame(), each
+  // show() sends every byte mix/256 of the way from the held frame to the
+  // current one. Brightness and dither apply to the current frame first, so
+  // the two frames may be at different levels.
+  void holdFrame() {
+    for (uint16_t i = 0; i < kBytes; i++) {
+      const uint8_t c = (uint8_t)(scaleByte(raw[i]) >> 8);
+      held[i] = mixing ? mixByte(held[i], c) : c;
+    }
+    mix = 0;
+    mixing = true;
+  }
+  void setMix(uint8_t m) { mix = m; }
+  void releaseFrame() { mixing = false; }
+  bool holdingFrame() const { return mixing; }
+
+  static constexpr uint32_t Color(uint8_t r, uint8_t g, uint8_t b) {
+    return ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+  }
+
+private:
+  static constexpr uint16_t kBytes = Count * 3;
+  static constexpr uint8_t kR = (Order >> 4) & 3;
+  static constexpr uint8_t kG = (Order >> 2) & 3;
+  static constexpr uint8_t kB = Order & 3;
+  static constexpr uint8_t kPortIo = Ws2812Pins::portIoAddr(Ws2812Pins::portOf(Pin));
+  static constexpr uint8_t kMask = (uint8_t)(1u << Ws2812Pins::bitOf(Pin));
+  static constexpr uint16_t kLatchUs = 300; // WS2812B needs >280us low between frames
+
+  static constexpr uint16_t kFullLevel = 0xFF00; // brightness 255: sent without scaling
+
+  uint8_t raw[kBytes + 1] = {}; // +1: sent as is at full level, and send() reads one past the end
+  uint8_t residual[kBytes] = {}; // dither: fraction carried from the last show()
+  uint8_t held[kBytes] = {};     // crossfade: the frame being faded from, as sent
+  uint16_t level = kFullLevel;   // brightness, 8.8
+  uint8_t mix = 0;               // crossfade: 0 = held frame .. 255 = ~current
+  bool dither = false;
+  bool mixing = false;
+  uint32_t endUs = 0;
+
+  // Channel byte c at the current brightness: c * (level + 256) / 65536, as
+  // 8.8 from two 8x8 multiplies (level <= 0xFF00 keeps it, plus the carried
+  // fraction, within 16 bits). Bounded at ~20 cycles on AVR either way.
+  uint16_t scaleByte(uint8_t c) const {
+    return (uint16_t)(c * (uint8_t)(level >> 8) + ((c * (uint8_t)level) >> 8) + c);
+  }
+
+  // from + (to - from) * mix / 256 with one 8x8 multiply: ~12 cycles on AVR.
+  uint8_t mixByte(uint8_t from, uint8_t to) const {
+    return (to >= from) ? (uint8_t)(from + (((uint8_t)(to - from) * mix) >> 8))
+                        : (uint8_t)(from - (((uint8_t)(from - to) * mix) >> 8));
+  }
+
+  uint8_t outputByte(uint16_t i, uint8_t c) {
+    uint16_t v = scaleByte(c);
+    if (dither) {
+      v = (uint16_t)(v + residual[i]);
+      residual[i] = (uint8_t)v;
+    }
+    return mixing ? mixByte(held[i], (uint8_t)(v >> 8)) : (uint8_t)(v >> 8);
+  }
+
+#if defined(__AVR__)
+#if F_CPU != 16000000L
+#error "Ws2812 output loop is timed for 16 MHz"
+#endif
+
+  // 20 cycles (1.25us) per bit. The line goes high at T=0, low at T=5
+  // (312ns) for a 0 bit or T=12 (750ns) for a 1 bit. Same structure as
+  // Adafruit_NeoPixel's 16 MHz loop, but with the port known at compile time
+  // so every edge is a 1-cycle OUT instead of a 2-cycle ST through a pointer.
+  static void send(const uint8_t *ptr) {
+    const uint8_t sreg = SREG;
+    cli();
+
+    const uint8_t hi = _SFR_IO8(kPortIo) | kMask;
+    const uint8_t lo = _SFR_IO8(kPortIo) & (uint8_t)~kMask;
+    uint8_t next = lo;
+    uint8_t bit = 8;
+    uint8_t byte = *ptr++;
+    uint16_t count = kBytes;
+
+    asm volatile(
+        "1:"                         "\n\t" // Clk  (T = 0)
+        "out  %[port], %[hi]"        "\n\t" // 1    PORT = hi            (T =  1)
+        "sbrc %[byte], 7"            "\n\t" // 1-2  if (byte & 0x80)
+        "mov  %[next], %[hi]"        "\n\t" // 0-1    next = hi          (T =  3)
+        "dec  %[bit]"                "\n\t" // 1    bit--                (T =  4)
+        "nop"                        "\n\t" // 1                         (T =  5)
+        "out  %[port], %[next]"      "\n\t" // 1    PORT = next          (T =  6)
+        "mov  %[next], %[lo]"        "\n\t" // 1    next = lo            (T =  7)
+        "breq 2f"                    "\n\t" // 1-2  if (bit == 0) -> next byte
+        "rol  %[byte]"               "\n\t" // 1    byte <<= 1           (T =  9)
+        "rjmp .+0"                   "\n\t" // 2                         (T = 11)
+        "nop"                        "\n\t" // 1                         (T = 12)
+        "out  %[port], %[lo]"        "\n\t" // 1    PORT = lo            (T = 13)
+        "rjmp .+0"                   "\n\t" // 2                         (T = 15)
+        "rjmp .+0"                   "\n\t" // 2                         (T = 17)
+        "nop"                        "\n\t" // 1                         (T = 18)
+        "rjmp 1b"                    "\n\t" // 2    next bit             (T = 20)
+        "2:"                         "\n\t" //                           (T =  9)
+        "ldi  %[bit], 8"             "\n\t" // 1    bit = 8              (T = 10)
+        "ld   %[byte], %a[ptr]+"     "\n\t" // 2    byte = *ptr++        (T = 12)
+        "out  %[port], %[lo]"        "\n\t" // 1    PORT = lo            (T = 13)
+        "nop"                        "\n\t" // 1                         (T = 14)
+        "sbiw %[count], 1"           "\n\t" // 2    count--              (T = 16)
+        "rjmp .+0"                   "\n\t" // 2                         (T = 18)
+        "brne 1b"                    "\n"   // 2    next byte            (T = 20)
+        : [byte] "+r"(byte), [bit] "+d"(bit), [next] "+r"(next), [count] "+w"(count), [ptr] "+e"(ptr)
+        : [port] "I"(kPortIo), [hi] "r"(hi), [lo] "r"(lo));
+
+    SREG = sreg;
+  }
+#endif
+};
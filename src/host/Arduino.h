@@ -0,0 +1,118 @@
+#pragma once
+
+// Host (native) stand-in for the small slice of the Arduino core the firmware
+// uses. Time, serial and pins are driven by the simulation in host_runtime.cpp
+// so the same src/main.cpp can run on a PC against a simulated clock.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t *)(addr))
+
+class __FlashStringHelper;
+#define F(s) (reinterpret_cast<const __FlashStringHelper *>(s))
+
+static constexpr uint8_t LOW = 0;
+static constexpr uint8_t HIGH = 1;
+
+static constexpr uint8_t INPUT = 0;
+static constexpr uint8_t OUTPUT = 1;
+static constexpr uint8_t INPUT_PULLUP = 2;
+
+// ATmega32U4 (Leonardo/Pro Micro variant) analog pin numbers.
+static constexpr uint8_t A0 = 18;
+static constexpr uint8_t A1 = 19;
+static constexpr uint8_t A2 = 20;
+static constexpr uint8_t A3 = 21;
+static constexpr uint8_t A9 = 27;
+
+static constexpr uint8_t HostPinCount = 32;
+
+// Reset cause register (MCU Status Register) and its flag bits. Reads as a
+// power-on reset unless the driver sets it before setup().
+extern uint8_t MCUSR;
+static constexpr uint8_t PORF = 0;
+static constexpr uint8_t EXTRF = 1;
+static constexpr uint8_t BORF = 2;
+static constexpr uint8_t WDRF = 3;
+
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint16_t us);
+
+void pinMode(uint8_t pin, uint8_t mode);
+int digitalRead(uint8_t pin);
+void digitalWrite(uint8_t pin, uint8_t value);
+
+class Print {
+public:
+  virtual ~Print() {}
+
+  virtual size_t write(uint8_t b) = 0;
+
+  size_t write(const uint8_t *buf, size_t len) {
+    size_t n = 0;
+    while (len--) {
+      n += write(*buf++);
+    }
+    return n;
+  }
+
+  size_t print(const __FlashStringHelper *s) { return print(reinterpret_cast<const char *>(s)); }
+  size_t print(const char *s) { return write(reinterpret_cast<const uint8_t *>(s), strlen(s)); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(unsigned long v) { return printNumber(v); }
+  size_t print(unsigned int v) { return printNumber(v); }
+  size_t print(unsigned char v) { return printNumber(v); }
+  size_t print(long v) { return (v < 0) ? print('-') + printNumber((unsigned long)-v) : printNumber((unsigned long)v); }
+  size_t print(int v) { return print((long)v); }
+
+  size_t println() { return print("\r\n"); }
+
+  template <typename T>
+  size_t println(T v) {
+    const size_t n = print(v);
+    return n + println();
+  }
+
+private:
+  size_t printNumber(unsigned long v) {
+    char buf[3 * sizeof(unsigned long) + 1];
+    char *p = &buf[sizeof(buf) - 1];
+    *p = '\0';
+    do {
+      *--p = (char)('0' + (v % 10));
+      v /= 10;
+    } while (v != 0);
+    return print(p);
+  }
+};
+
+// Serial port backed by the host simulation (see host_runtime.h).
+class HostSerial : public Print {
+public:
+  explicit HostSerial(uint8_t port) : portIndex(port) {}
+
+  void begin(uint32_t baud);
+  int available();
+  int read();
+  int availableForWrite();
+  void flush();
+  size_t write(uint8_t b) override;
+  using Print::write;
+  explicit operator bool() const { return true; }
+
+private:
+  uint8_t portIndex;
+};
+
+extern HostSerial Serial;
+extern HostSerial Serial1;
+
+void setup();
+void loop();
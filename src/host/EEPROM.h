@@ -0,0 +1,25 @@
+#pragma once
+
+// Host (native) stand-in for the Arduino EEPROM library plus avr-libc's
+// eeprom_is_ready(). Contents live in host_runtime.cpp and survive
+// Host::reset(), like the real part. Writes take Host::kEepromWriteUs of
+// simulated time in the background; touching the EEPROM again before that
+// blocks, as on the ATmega32U4.
+
+#include <stdint.h>
+
+class EEPROMClass {
+public:
+  uint8_t read(int idx);
+  void write(int idx, uint8_t value);
+  void update(int idx, uint8_t value) {
+    if (read(idx) != value) {
+      write(idx, value);
+    }
+  }
+  uint16_t length();
+};
+
+extern EEPROMClass EEPROM;
+
+bool eeprom_is_ready();
@@ -0,0 +1,580 @@
+#include "frame_trace.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr size_t kHeaderBytes = 16;
+constexpr size_t kBlockHeaderBytes = 16;
+constexpr size_t kIndexEntryBytes = 24;
+constexpr size_t kFooterBytes = 24;
+constexpr size_t kMaxRun = 128;
+
+// Delta kind byte (format in frame_trace.h).
+enum Kind : uint8_t {
+  Same = 0,
+  MaskBytes = 1,
+  MaskNibbles = 2,
+  Runs = 3,
+};
+constexpr uint8_t kKindMask = 0x03;
+constexpr uint8_t kRepeatStep = 0x04;
+
+void putLe(std::vector<uint8_t> &out, uint64_t v, uint8_t bytes) {
+  for (uint8_t i = 0; i < bytes; i++) {
+    out.push_back((uint8_t)(v >> (8 * i)));
+  }
+}
+
+uint64_t getLe(const uint8_t *p, uint8_t bytes) {
+  uint64_t v = 0;
+  for (uint8_t i = 0; i < bytes; i++) {
+    v |= (uint64_t)p[i] << (8 * i);
+  }
+  return v;
+}
+
+void putVarint(std::vector<uint8_t> &out, uint64_t v) {
+  while (v >= 0x80) {
+    out.push_back((uint8_t)(v | 0x80));
+    v >>= 7;
+  }
+  out.push_back((uint8_t)v);
+}
+
+bool getVarint(const uint8_t *&p, const uint8_t *end, uint64_t &v) {
+  v = 0;
+  for (uint8_t shift = 0; shift < 64; shift += 7) {
+    if (p >= end) {
+      return false;
+    }
+    const uint8_t b = *p++;
+    v |= (uint64_t)(b & 0x7F) << shift;
+    if (!(b & 0x80)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// XOR of cur against prev as run-length tokens. A single unchanged byte
+// between changed ones stays in the literal run: that costs one byte,
+// splitting the run costs two.
+void encodeRuns(const uint8_t *prev, const uint8_t *cur, size_t n, std::vector<uint8_t> &out) {
+  size_t i = 0;
+  while (i < n) {
+    size_t same = 0;
+    while (i + same < n && prev[i + same] == cur[i + same]) {
+      same++;
+    }
+    if (same != 0) {
+      i += same;
+      for (; same > kMaxRun; same -= kMaxRun) {
+        out.push_back((uint8_t)(kMaxRun - 1));
+      }
+      out.push_back((uint8_t)(same - 1));
+      continue;
+    }
+
+    const size_t start = i;
+    while (i < n && i - start < kMaxRun) {
+      if (prev[i] != cur[i]) {
+        i++;
+      } else if (i + 1 < n && prev[i + 1] != cur[i + 1] && i + 2 - start <= kMaxRun) {
+        i += 2;
+      } else {
+        break;
+      }
+    }
+    out.push_back((uint8_t)(0x80 | (i - start - 1)));
+    for (size_t k = start; k < i; k++) {
+      out.push_back((uint8_t)(prev[k] ^ cur[k]));
+    }
+  }
+}
+
+// One delta frame, coded whichever way is shortest.
+void encodeDelta(const uint8_t *prev, const uint8_t *cur, size_t n, uint64_t stepUs, bool repeatStep,
+                 std::vector<uint8_t> &out, std::vector<uint8_t> &scratch) {
+  size_t changed = 0;
+  uint8_t bits = 0;
+  for (size_t i = 0; i < n; i++) {
+    const uint8_t x = (uint8_t)(prev[i] ^ cur[i]);
+    changed += (x != 0);
+    bits |= x;
+  }
+
+  uint8_t kind = Same;
+  scratch.clear();
+  if (changed != 0) {
+    const bool nibbles = (bits & 0xF0) == 0;
+    const size_t maskSize = (n + 7) / 8 + (nibbles ? (changed + 1) / 2 : changed);
+    encodeRuns(prev, cur, n, scratch);
+    if (scratch.size() < maskSize) {
+      kind = Runs;
+    } else {
+      kind = nibbles ? MaskNibbles : MaskBytes;
+      scratch.assign((n + 7) / 8, 0);
+      bool high = false;
+      for (size_t i = 0; i < n; i++) {
+        const uint8_t x = (uint8_t)(prev[i] ^ cur[i]);
+        if (x == 0) {
+          continue;
+        }
+        scratch[i / 8] |= (uint8_t)(1u << (i % 8));
+        if (!nibbles) {
+          scratch.push_back(x);
+        } else if (high) {
+          scratch.back() |= (uint8_t)(x << 4);
+        } else {
+          scratch.push_back(x);
+        }
+        high = nibbles && !high;
+      }
+    }
+  }
+
+  out.push_back((uint8_t)(kind | (repeatStep ? kRepeatStep : 0)));
+  if (!repeatStep) {
+    putVarint(out, stepUs);
+  }
+  out.insert(out.end(), scratch.begin(), scratch.end());
+}
+
+} // namespace
+
+namespace FrameTrace {
+
+// ----------------------------
+// Writer
+// ----------------------------
+
+bool Writer::open(const char *path, uint16_t pixels, uint16_t framesPerBlock) {
+  close();
+  if (pixels == 0 || framesPerBlock == 0) {
+    return false;
+  }
+  file = fopen(path, "wb");
+  if (!file) {
+    return false;
+  }
+  ok = true;
+  pixelCount = pixels;
+  perBlock = framesPerBlock;
+  written = 0;
+  frameCount = 0;
+  lastUs = 0;
+  prev.assign((size_t)pixels * 3, 0);
+  payload.clear();
+  blockFrames = 0;
+  index.clear();
+
+  std::vector<uint8_t> header = {'T', 'C', 'F', 'T', kVersion, 0};
+  putLe(header, pixels, 2);
+  putLe(header, framesPerBlock, 2);
+  header.resize(kHeaderBytes, 0);
+  put(header.data(), header.size());
+  return ok;
+}
+
+bool Writer::add(uint64_t atUs, const uint8_t *rgb) {
+  if (!file || (frameCount != 0 && atUs < lastUs)) {
+    return false;
+  }
+  const size_t n = prev.size();
+  if (blockFrames == 0) {
+    blockUs = atUs;
+    payload.insert(payload.end(), rgb, rgb + n);
+  } else {
+    const uint64_t stepUs = atUs - lastUs;
+    encodeDelta(prev.data(), rgb, n, stepUs, blockFrames > 1 && stepUs == lastStepUs, payload, scratch);
+    lastStepUs = stepUs;
+  }
+  memcpy(prev.data(), rgb, n);
+  lastUs = atUs;
+  frameCount++;
+  if (++blockFrames == perBlock) {
+    flushBlock();
+  }
+  return ok;
+}
+
+bool Writer::flushBlock() {
+  if (blockFrames == 0) {
+    return ok;
+  }
+  putLe(index, written, 8);
+  putLe(index, blockUs, 8);
+  putLe(index, frameCount - blockFrames, 8);
+
+  std::vector<uint8_t> header;
+  putLe(header, blockUs, 8);
+  putLe(header, blockFrames, 4);
+  putLe(header, payload.size(), 4);
+  put(header.data(), header.size());
+  put(payload.data(), payload.size());
+  payload.clear();
+  blockFrames = 0;
+  return ok;
+}
+
+bool Writer::close() {
+  if (!file) {
+    return ok;
+  }
+  flushBlock();
+  const uint64_t indexOffset = written;
+  put(index.data(), index.size());
+
+  std::vector<uint8_t> footer;
+  putLe(footer, indexOffset, 8);
+  putLe(footer, lastUs, 8);
+  putLe(footer, index.size() / kIndexEntryBytes, 4);
+  footer.insert(footer.end(), {'T', 'C', 'F', 'I'});
+  put(footer.data(), footer.size());
+
+  ok = (fclose(file) == 0) && ok;
+  file = nullptr;
+  return ok;
+}
+
+void Writer::put(const void *data, size_t len) {
+  if (len != 0 && fwrite(data, 1, len, file) != len) {
+    ok = false;
+  }
+  written += len;
+}
+
+// ----------------------------
+// Reader
+// ----------------------------
+
+bool Reader::open(const char *path) {
+  close();
+  fd = ::open(path, O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < kHeaderBytes) {
+    close();
+    return false;
+  }
+  size = (size_t)st.st_size;
+  void *m = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (m == MAP_FAILED) {
+    close();
+    return false;
+  }
+  map = static_cast<const uint8_t *>(m);
+
+  pixelCount = (uint16_t)getLe(map + 6, 2);
+  perBlock = (uint16_t)getLe(map + 8, 2);
+  if (memcmp(map, "TCFT", 4) != 0 || map[4] != kVersion || pixelCount == 0) {
+    close();
+    return false;
+  }
+
+  if (size >= kHeaderBytes + kFooterBytes && memcmp(map + size - 4, "TCFI", 4) == 0) {
+    const uint8_t *footer = map + size - kFooterBytes;
+    const uint64_t indexOffset = getLe(footer, 8);
+    blockCount = (uint32_t)getLe(footer + 16, 4);
+    hadFooter = indexOffset >= kHeaderBytes &&
+                indexOffset + (uint64_t)blockCount * kIndexEntryBytes == size - kFooterBytes;
+    if (hadFooter) {
+      indexBase = map + indexOffset;
+      lastFrameUs = getLe(footer + 8, 8);
+      if (!checkIndex(indexOffset)) {
+        close();
+        return false;
+      }
+      return true;
+    }
+  }
+  if (!rebuildIndex()) {
+    close();
+    return false;
+  }
+  return true;
+}
+
+// Every block the index lists must lie between the header and the index, in
+// file order, start no earlier than the block before (seek() binary-searches
+// on that time, which must also match the block's own header) and number its
+// frames on from the previous one; sets frameCount. Cursors trust the index
+// after this.
+bool Reader::checkIndex(uint64_t indexOffset) {
+  frameCount = 0;
+  uint64_t minOffset = kHeaderBytes;
+  uint64_t minUs = 0;
+  for (uint32_t b = 0; b < blockCount; b++) {
+    const uint64_t off = blockOffset(b);
+    if (off < minOffset || off + kBlockHeaderBytes > indexOffset) {
+      return false;
+    }
+    const uint64_t firstUs = getLe(map + off, 8);
+    const uint64_t frames = getLe(map + off + 8, 4);
+    const uint64_t payloadBytes = getLe(map + off + 12, 4);
+    if (frames == 0 || payloadBytes < (uint64_t)pixelCount * 3 ||
+        off + kBlockHeaderBytes + payloadBytes > indexOffset || blockFirstFrame(b) != frameCount ||
+        blockUs(b) != firstUs || firstUs < minUs) {
+      return false;
+    }
+    frameCount += frames;
+    minOffset = off + kBlockHeaderBytes + payloadBytes;
+    minUs = firstUs;
+  }
+  return blockCount == 0 || lastFrameUs >= minUs;
+}
+
+bool Reader::rebuildIndex() {
+  rebuiltIndex.clear();
+  blockCount = 0;
+  frameCount = 0;
+  uint64_t off = kHeaderBytes;
+  uint64_t minUs = 0;
+  while (off + kBlockHeaderBytes <= size) {
+    const uint64_t firstUs = getLe(map + off, 8);
+    const uint64_t frames = getLe(map + off + 8, 4);
+    const uint64_t payloadBytes = getLe(map + off + 12, 4);
+    if (frames == 0 || payloadBytes < (uint64_t)pixelCount * 3 ||
+        off + kBlockHeaderBytes + payloadBytes > size) {
+      break; // the partial block the writer was on
+    }
+    if (firstUs < minUs) {
+      return false; // a complete block going back in time: not a cut-short trace
+    }
+    minUs = firstUs;
+    putLe(rebuiltIndex, off, 8);
+    putLe(rebuiltIndex, firstUs, 8);
+    putLe(rebuiltIndex, frameCount, 8);
+    blockCount++;
+    frameCount += frames;
+    off += kBlockHeaderBytes + payloadBytes;
+  }
+  indexBase = rebuiltIndex.data();
+  hadFooter = false;
+
+  // The last time is only in the footer; walk the last block for it.
+  lastFrameUs = 0;
+  if (blockCount != 0) {
+    Cursor c = begin();
+    c.enterBlock(blockCount - 1);
+    while (c.valid()) {
+      lastFrameUs = c.atUs();
+      c.next();
+    }
+  }
+  return true;
+}
+
+void Reader::close() {
+  if (map) {
+    munmap(const_cast<uint8_t *>(map), size);
+    map = nullptr;
+  }
+  if (fd >= 0) {
+    ::close(fd);
+    fd = -1;
+  }
+  size = 0;
+  indexBase = nullptr;
+  rebuiltIndex.clear();
+  blockCount = 0;
+  frameCount = 0;
+  lastFrameUs = 0;
+  hadFooter = false;
+}
+
+uint64_t Reader::blockOffset(uint32_t b) const { return getLe(indexBase + (size_t)b * kIndexEntryBytes, 8); }
+uint64_t Reader::blockUs(uint32_t b) const { return getLe(indexBase + (size_t)b * kIndexEntryBytes + 8, 8); }
+uint64_t Reader::blockFirstFrame(uint32_t b) const {
+  return getLe(indexBase + (size_t)b * kIndexEntryBytes + 16, 8);
+}
+
+Cursor Reader::begin() const {
+  Cursor c;
+  c.reader = this;
+  c.buf.resize((size_t)pixelCount * 3);
+  if (blockCount != 0) {
+    c.enterBlock(0);
+  }
+  return c;
+}
+
+Cursor Reader::seek(uint64_t atUs) const {
+  // Last block starting at or before atUs.
+  uint32_t lo = 0;
+  uint32_t hi = blockCount;
+  while (hi - lo > 1) {
+    const uint32_t mid = lo + (hi - lo) / 2;
+    if (blockUs(mid) <= atUs) {
+      lo = mid;
+    } else {
+      hi = mid;
+    }
+  }
+
+  Cursor c;
+  c.reader = this;
+  c.buf.resize((size_t)pixelCount * 3);
+  if (blockCount == 0 || !c.enterBlock(lo)) {
+    return c;
+  }
+  // Then forward through the block, looking ahead at each frame's time step
+  // only. A delta that does not decode leaves the cursor invalid.
+  while (c.inBlock + 1 < c.blockFrames && c.p < c.end) {
+    const uint8_t *q = c.p;
+    uint64_t stepUs = c.stepUs;
+    if (!(*q++ & kRepeatStep) && !getVarint(q, c.end, stepUs)) {
+      break;
+    }
+    if (c.us + stepUs > atUs || !c.next()) {
+      break;
+    }
+  }
+  return c;
+}
+
+// ----------------------------
+// Cursor
+// ----------------------------
+
+Cursor &Cursor::operator=(const Cursor &other) {
+  reader = other.reader;
+  block = other.block;
+  inBlock = other.inBlock;
+  blockFrames = other.blockFrames;
+  p = other.p;
+  end = other.end;
+  us = other.us;
+  stepUs = other.stepUs;
+  number = other.number;
+  buf = other.buf;
+  cur = (other.cur == other.buf.data()) ? buf.data() : other.cur;
+  return *this;
+}
+
+bool Cursor::enterBlock(uint32_t b) {
+  cur = nullptr;
+  if (b >= reader->blockCount) {
+    return false;
+  }
+  const uint8_t *header = reader->map + reader->blockOffset(b);
+  const size_t frameBytes = buf.size();
+  const uint64_t payloadBytes = getLe(header + 12, 4);
+  if (payloadBytes < frameBytes) {
+    return false;
+  }
+  block = b;
+  inBlock = 0;
+  blockFrames = (uint32_t)getLe(header + 8, 4);
+  us = getLe(header, 8);
+  stepUs = 0;
+  number = reader->blockFirstFrame(b);
+  cur = header + kBlockHeaderBytes; // the keyframe, in place
+  p = cur + frameBytes;
+  end = header + kBlockHeaderBytes + payloadBytes;
+  return true;
+}
+
+bool Cursor::next() {
+  if (!valid()) {
+    return false;
+  }
+  if (inBlock + 1 < blockFrames) {
+    inBlock++;
+    return decodeDelta();
+  }
+  return enterBlock(block + 1);
+}
+
+bool Cursor::decodeDelta() {
+  if (p >= end) {
+    cur = nullptr;
+    return false;
+  }
+  const uint8_t kind = *p++;
+  const bool repeatStep = (kind & kRepeatStep) != 0;
+  if ((kind & ~(kKindMask | kRepeatStep)) != 0 || (repeatStep && inBlock < 2) ||
+      (!repeatStep && !getVarint(p, end, stepUs))) {
+    cur = nullptr; // corrupt block
+    return false;
+  }
+  us += stepUs;
+  number++;
+
+  const size_t n = buf.size();
+  if (cur != buf.data()) {
+    memcpy(buf.data(), cur, n);
+    cur = buf.data();
+  }
+
+  bool ok = true;
+  switch (kind & kKindMask) {
+    case Same:
+      break;
+
+    case MaskBytes:
+    case MaskNibbles: {
+      const size_t maskBytes = (n + 7) / 8;
+      if ((size_t)(end - p) < maskBytes) {
+        ok = false;
+        break;
+      }
+      const uint8_t *mask = p;
+      p += maskBytes;
+      const bool nibbles = (kind & kKindMask) == MaskNibbles;
+      bool high = false;
+      for (size_t i = 0; i < n && ok; i++) {
+        if (!(mask[i / 8] & (1u << (i % 8)))) {
+          continue;
+        }
+        if (p >= end) {
+          ok = false;
+        } else if (!nibbles) {
+          buf[i] ^= *p++;
+        } else if (high) {
+          buf[i] ^= (uint8_t)(*p++ >> 4);
+        } else {
+          buf[i] ^= (uint8_t)(*p & 0x0F);
+        }
+        high = nibbles && !high;
+      }
+      if (high) {
+        p++; // odd count: the last byte's high nibble is unused
+      }
+      break;
+    }
+
+    case Runs: {
+      size_t pos = 0;
+      while (pos < n && p < end) {
+        const uint8_t t = *p++;
+        if (t < 0x80) {
+          pos += (size_t)t + 1;
+          continue;
+        }
+        const size_t len = (size_t)(t & 0x7F) + 1;
+        if (len > (size_t)(end - p) || pos + len > n) {
+          break;
+        }
+        for (size_t k = 0; k < len; k++) {
+          buf[pos++] ^= *p++;
+        }
+      }
+      ok = pos == n;
+      break;
+    }
+  }
+  if (!ok) {
+    cur = nullptr; // corrupt block
+  }
+  return ok;
+}
+
+} // namespace FrameTrace
@@ -0,0 +1,185 @@
+#pragma once
+
+// Frame traces: every show() of a long run, compact enough to keep hours of
+// it and indexed so a tool can jump to any time without reading the rest.
+//
+// Consecutive frames differ in a few bytes at most (a chase moves one pixel,
+// a hold or dither resend changes nothing or the low bits), so frames are
+// stored as the XOR against the previous frame, with a full keyframe at the
+// start of every block. Each delta is coded whichever way is shortest: a mask
+// of changed bytes with their XORs (as nibbles when all are below 16), or
+// run-length tokens for a long ring with few changes. Frames usually come at
+// a steady rate, so a repeated time step costs nothing. Blocks are listed in
+// an index at the end of the file; Reader maps the file, checks each index
+// entry against it once (O(blocks), no payload is read) and binary-searches
+// the index, so seeking is O(log blocks + framesPerBlock).
+//
+// File format, version 1 (all integers little-endian):
+//
+//   header   16 bytes: "TCFT", version, 0, pixel count (u16),
+//                      frames per block (u16), 6 reserved
+//   block    u64 time of its first frame (us), u32 frame count,
+//            u32 payload bytes, then the payload:
+//              keyframe  pixel count x R,G,B
+//              delta     kind byte:
+//                          bits 0-1  0 = same as the previous frame
+//                                    1 = mask, XOR bytes
+//                                    2 = mask, XOR nibbles
+//                                    3 = run-length tokens
+//                          bit 2     same time step as the previous delta
+//                                    in this block
+//                        then, unless bit 2, varint microseconds since the
+//                        previous frame, then the data:
+//                          mask      (pixel count x 3 + 7) / 8 bytes, bit i
+//                                    of byte i/8 set if frame byte i changed,
+//                                    then one XOR per set bit in order, as
+//                                    bytes or two per byte, low nibble first
+//                          tokens    covering pixel count x 3 bytes:
+//                                    0x00-0x7F  1-128 bytes unchanged
+//                                    0x80-0xFF  1-128 XOR bytes follow
+//   index    per block: u64 file offset, u64 first time (us), u64 first
+//            frame number
+//   footer   24 bytes: u64 index offset, u64 last frame time (us),
+//            u32 block count, "TCFI"
+//
+// A file cut short (the writer never closed it) has no footer; Reader then
+// rebuilds the index by walking the block headers and drops a partial block.
+// A footer whose index points outside the blocks, or whose block times or
+// frame numbers go backwards, fails open(); so does a rebuilt index whose
+// block times go backwards.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <vector>
+
+namespace FrameTrace {
+
+static constexpr uint8_t kVersion = 1;
+static constexpr uint16_t kDefaultFramesPerBlock = 256;
+
+class Writer {
+public:
+  Writer() = default;
+  Writer(const Writer &) = delete;
+  Writer &operator=(const Writer &) = delete;
+  ~Writer() { close(); }
+
+  bool open(const char *path, uint16_t pixels, uint16_t framesPerBlock = kDefaultFramesPerBlock);
+  // Times must not go backwards. rgb is pixels x R,G,B.
+  bool add(uint64_t atUs, const uint8_t *rgb);
+  // Flushes the last block and writes the index. False on any write error
+  // since open().
+  bool close();
+
+  uint64_t frames() const { return frameCount; }
+  uint64_t bytes() const { return written; }
+
+private:
+  bool flushBlock();
+  void put(const void *data, size_t len);
+
+  FILE *file = nullptr;
+  bool ok = false;
+  uint16_t pixelCount = 0;
+  uint16_t perBlock = 0;
+  uint64_t written = 0;
+  uint64_t frameCount = 0;
+  uint64_t lastUs = 0;
+
+  std::vector<uint8_t> prev;
+  std::vector<uint8_t> payload;
+  uint64_t blockUs = 0;
+  uint32_t blockFrames = 0;
+  uint64_t lastStepUs = 0;
+  std::vector<uint8_t> index;
+  std::vector<uint8_t> scratch;
+};
+
+class Reader;
+
+// A position in a trace. rgb() points into the mapped file for keyframes and
+// into the cursor's own buffer otherwise; it is valid until the next call.
+class Cursor {
+public:
+  Cursor() = default;
+  Cursor(const Cursor &other) { *this = other; }
+  Cursor &operator=(const Cursor &other);
+  Cursor(Cursor &&) = default;
+  Cursor &operator=(Cursor &&) = default;
+
+  bool valid() const { return reader != nullptr && cur != nullptr; }
+  uint64_t atUs() const { return us; }
+  uint64_t frame() const { return number; }
+  const uint8_t *rgb() const { return cur; }
+
+  // Move to the next frame. False (and invalid) past the last one.
+  bool next();
+
+private:
+  friend class Reader;
+  bool enterBlock(uint32_t block);
+  bool decodeDelta();
+
+  const Reader *reader = nullptr;
+  uint32_t block = 0;
+  uint32_t inBlock = 0;
+  uint32_t blockFrames = 0;
+  const uint8_t *p = nullptr;
+  const uint8_t *end = nullptr;
+  uint64_t us = 0;
+  uint64_t stepUs = 0;
+  uint64_t number = 0;
+  const uint8_t *cur = nullptr;
+  std::vector<uint8_t> buf;
+};
+
+class Reader {
+public:
+  Reader() = default;
+  Reader(const Reader &) = delete;
+  Reader &operator=(const Reader &) = delete;
+  ~Reader() { close(); }
+
+  // Maps the file read-only. Nothing is decoded until a cursor asks for it.
+  bool open(const char *path);
+  void close();
+
+  uint16_t pixels() const { return pixelCount; }
+  uint16_t framesPerBlock() const { return perBlock; }
+  uint32_t blocks() const { return blockCount; }
+  uint64_t frames() const { return frameCount; }
+  uint64_t firstUs() const { return blockCount ? blockUs(0) : 0; }
+  uint64_t lastUs() const { return lastFrameUs; }
+  size_t bytes() const { return size; }
+  // False if the footer was missing and the index had to be rebuilt.
+  bool indexed() const { return hadFooter; }
+
+  Cursor begin() const;
+  // The last frame at or before atUs (the first frame if atUs is earlier).
+  // Invalid if a frame on the way there does not decode.
+  Cursor seek(uint64_t atUs) const;
+
+private:
+  friend class Cursor;
+  uint64_t blockOffset(uint32_t b) const;
+  uint64_t blockUs(uint32_t b) const;
+  uint64_t blockFirstFrame(uint32_t b) const;
+  bool checkIndex(uint64_t indexOffset);
+  bool rebuildIndex();
+
+  int fd = -1;
+  const uint8_t *map = nullptr;
+  size_t size = 0;
+  uint16_t pixelCount = 0;
+  uint16_t perBlock = 0;
+  const uint8_t *indexBase = nullptr;
+  std::vector<uint8_t> rebuiltIndex;
+  uint32_t blockCount = 0;
+  uint64_t frameCount = 0;
+  uint64_t lastFrameUs = 0;
+  bool hadFooter = false;
+};
+
+} // namespace FrameTrace
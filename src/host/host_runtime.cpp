@@ -0,0 +1,316 @@
+#include "host_runtime.h"
+
+#include <Arduino.h>
+#include <EEPROM.h>
+
+#include "ws2812.h"
+
+#include <chrono>
+#include <deque>
+#include <thread>
+
+HostSerial Serial(0);
+HostSerial Serial1(1);
+EEPROMClass EEPROM;
+uint8_t MCUSR = 1u << PORF;
+
+namespace {
+
+struct RxByte {
+  uint64_t atUs;
+  uint8_t b;
+};
+
+struct Port {
+  Host::SerialModel model;
+  std::deque<RxByte> rx;
+  uint64_t txBusyUntilUs = 0;
+  uint64_t txBytes = 0;
+  Host::SerialTxSink txSink = nullptr;
+  void *txSinkUser = nullptr;
+};
+
+struct State {
+  uint64_t nowUs = 0;
+
+  Port ports[Host::kSerialPorts];
+
+  bool pinHigh[HostPinCount];
+
+  Host::FrameHook frameHook = nullptr;
+  void *frameHookUser = nullptr;
+
+  State() {
+    for (bool &p : pinHigh) {
+      p = true;
+    }
+  }
+};
+
+// Per thread, so host drivers can run independent boards side by side
+// (sim_fleet). The EEPROM below is shared.
+thread_local State state;
+
+// Non-volatile: outside State so reset() keeps it.
+struct Eeprom {
+  uint8_t data[Host::kEepromBytes];
+  uint32_t writes[Host::kEepromBytes] = {};
+  uint64_t busyUntilUs = 0;
+
+  Eeprom() { memset(data, 0xFF, sizeof(data)); }
+};
+
+Eeprom eepromState;
+
+struct Battery {
+  Host::BatteryModel model;
+  double usedMah = 0.0;
+  double loadMa = 0.0;
+  uint64_t lastUs = 0;
+  uint32_t noise = 1;
+};
+
+thread_local Battery battery;
+
+void drawBattery() {
+  const uint64_t now = state.nowUs;
+  if (now > battery.lastUs) {
+    battery.usedMah += battery.loadMa * (double)(now - battery.lastUs) / 3.6e9;
+  }
+  battery.lastUs = now;
+}
+
+void waitEeprom() {
+  if (eepromState.busyUntilUs > state.nowUs) {
+    state.nowUs = eepromState.busyUntilUs;
+  }
+}
+
+Port &port(uint8_t index) { return state.ports[(index < Host::kSerialPorts) ? index : 0]; }
+
+uint32_t txQueued(const Port &p) {
+  if (p.model.txByteUs == 0 || p.txBusyUntilUs <= state.nowUs) {
+    return 0;
+  }
+  const uint64_t busy = p.txBusyUntilUs - state.nowUs;
+  return (uint32_t)((busy + p.model.txByteUs - 1) / p.model.txByteUs);
+}
+
+} // namespace
+
+namespace Host {
+
+uint64_t nowUs() { return state.nowUs; }
+
+void advanceUs(uint64_t us) { state.nowUs += us; }
+
+void setSerialModel(const SerialModel &model, uint8_t index) { port(index).model = model; }
+
+void pushSerialRx(uint8_t b, uint64_t atUs, uint8_t index) { port(index).rx.push_back(RxByte{atUs, b}); }
+
+void pushSerialRx(const char *s, uint64_t atUs, uint8_t index) {
+  while (*s) {
+    pushSerialRx((uint8_t)*s++, atUs, index);
+  }
+}
+
+void clearSerialRx(uint8_t index) { port(index).rx.clear(); }
+
+uint32_t pendingSerialRx(uint8_t index) { return (uint32_t)port(index).rx.size(); }
+
+void setSerialTxSink(SerialTxSink sink, void *user, uint8_t index) {
+  port(index).txSink = sink;
+  port(index).txSinkUser = user;
+}
+
+uint64_t serialTxBytes(uint8_t index) { return port(index).txBytes; }
+
+void setPinLevel(uint8_t pin, bool high) {
+  if (pin < HostPinCount) {
+    state.pinHigh[pin] = high;
+  }
+}
+
+void setFrameHook(FrameHook hook, void *user) {
+  state.frameHook = hook;
+  state.frameHookUser = user;
+}
+
+uint8_t *eeprom() { return eepromState.data; }
+
+uint32_t eepromWriteCount(uint16_t addr) { return (addr < kEepromBytes) ? eepromState.writes[addr] : 0; }
+
+void setBattery(const BatteryModel &model) {
+  battery = Battery();
+  battery.model = model;
+  battery.lastUs = state.nowUs;
+  battery.loadMa = model.boardMa;
+}
+
+double batteryUsedMah() {
+  drawBattery();
+  return battery.usedMah;
+}
+
+uint16_t batteryMv() {
+  drawBattery();
+  const BatteryModel &m = battery.model;
+  if (m.curvePoints < 2) {
+    return 5000;
+  }
+  // Linear interpolation along the curve by fraction of capacity drawn.
+  const double pos = battery.usedMah / m.capacityMah * (m.curvePoints - 1);
+  if (pos >= m.curvePoints - 1) {
+    return m.curveMv[m.curvePoints - 1];
+  }
+  const uint8_t i = (uint8_t)pos;
+  const double f = pos - i;
+  return (uint16_t)(m.curveMv[i] + (m.curveMv[i + 1] - m.curveMv[i]) * f);
+}
+
+void paceRealtime() {
+  using Clock = std::chrono::steady_clock;
+  static const Clock::time_point start = Clock::now();
+  static const uint64_t startSimUs = state.nowUs;
+
+  const uint64_t wallUs =
+      startSimUs + (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count();
+  if (state.nowUs < wallUs) {
+    state.nowUs = wallUs;
+  } else if (state.nowUs > wallUs) {
+    std::this_thread::sleep_for(std::chrono::microseconds(state.nowUs - wallUs));
+  }
+}
+
+void reset() {
+  const State previous = state;
+  state = State();
+  eepromState.busyUntilUs = 0;
+  MCUSR = 1u << PORF;
+  for (uint8_t i = 0; i < kSerialPorts; i++) {
+    state.ports[i].txSink = previous.ports[i].txSink;
+    state.ports[i].txSinkUser = previous.ports[i].txSinkUser;
+  }
+  state.frameHook = previous.frameHook;
+  state.frameHookUser = previous.frameHookUser;
+}
+
+} // namespace Host
+
+// ----------------------------
+// Arduino core stand-ins
+// ----------------------------
+uint32_t millis() { return (uint32_t)(state.nowUs / 1000); }
+
+uint32_t micros() { return (uint32_t)state.nowUs; }
+
+void delay(uint32_t ms) { state.nowUs += (uint64_t)ms * 1000; }
+
+void delayMicroseconds(uint16_t us) { state.nowUs += us; }
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  (void)pin;
+  (void)mode;
+}
+
+int digitalRead(uint8_t pin) { return (pin < HostPinCount && state.pinHigh[pin]) ? HIGH : LOW; }
+
+void digitalWrite(uint8_t pin, uint8_t value) { Host::setPinLevel(pin, value != LOW); }
+
+void HostSerial::begin(uint32_t baud) { (void)baud; }
+
+int HostSerial::available() {
+  int n = 0;
+  for (const RxByte &r : ::port(portIndex).rx) {
+    if (r.atUs > state.nowUs) {
+      break;
+    }
+    n++;
+  }
+  return n;
+}
+
+int HostSerial::read() {
+  Port &p = ::port(portIndex);
+  if (p.rx.empty() || p.rx.front().atUs > state.nowUs) {
+    return -1;
+  }
+  const uint8_t b = p.rx.front().b;
+  p.rx.pop_front();
+  state.nowUs += p.model.rxReadUs;
+  return b;
+}
+
+int HostSerial::availableForWrite() {
+  const Port &p = ::port(portIndex);
+  return (int)p.model.txFifoBytes - (int)txQueued(p);
+}
+
+void HostSerial::flush() {
+  const Port &p = ::port(portIndex);
+  if (p.txBusyUntilUs > state.nowUs) {
+    state.nowUs = p.txBusyUntilUs;
+  }
+}
+
+size_t HostSerial::write(uint8_t b) {
+  Port &p = ::port(portIndex);
+  if (p.model.txByteUs != 0) {
+    // Blocking write: wait for room in the FIFO, as the real port does.
+    if (txQueued(p) >= p.model.txFifoBytes) {
+      state.nowUs = p.txBusyUntilUs - (uint64_t)(p.model.txFifoBytes - 1) * p.model.txByteUs;
+    }
+    const uint64_t start = (p.txBusyUntilUs > state.nowUs) ? p.txBusyUntilUs : state.nowUs;
+    p.txBusyUntilUs = start + p.model.txByteUs;
+  }
+
+  p.txBytes++;
+  if (p.txSink) {
+    p.txSink(b, p.txSinkUser);
+  }
+  return 1;
+}
+
+uint16_t hostReadBandgapAdc() {
+  const uint32_t vcc = Host::batteryMv();
+  battery.noise = battery.noise * 1103515245u + 12345u;
+  const int jitter = (int)((battery.noise >> 16) % 3) - 1;
+  const int adc = (int)((uint32_t)battery.model.bandgapMv * 1024u / vcc) + jitter;
+  state.nowUs += Host::kAdcConversionUs;
+  return (uint16_t)((adc < 1) ? 1 : (adc > 1023 ? 1023 : adc));
+}
+
+void ws2812HostShow(const uint8_t *rgb, uint16_t count, uint16_t latchWaitUs) {
+  state.nowUs += latchWaitUs;
+  drawBattery();
+  uint32_t levels = 0;
+  for (uint16_t i = 0; i < count * 3u; i++) {
+    levels += rgb[i];
+  }
+  battery.loadMa = battery.model.boardMa + battery.model.ledIdleMa * count +
+                   battery.model.ledMaPerChannel * (double)levels / 255.0;
+
+  if (state.frameHook) {
+    state.frameHook(state.nowUs, rgb, count, state.frameHookUser);
+  }
+  state.nowUs += (uint64_t)Host::kShowUsPerPixel * count;
+}
+
+uint8_t EEPROMClass::read(int idx) {
+  waitEeprom();
+  return (idx >= 0 && idx < Host::kEepromBytes) ? eepromState.data[idx] : 0xFF;
+}
+
+void EEPROMClass::write(int idx, uint8_t value) {
+  waitEeprom();
+  if (idx < 0 || idx >= Host::kEepromBytes) {
+    return;
+  }
+  eepromState.data[idx] = value;
+  eepromState.writes[idx]++;
+  eepromState.busyUntilUs = state.nowUs + Host::kEepromWriteUs;
+}
+
+uint16_t EEPROMClass::length() { return Host::kEepromBytes; }
+
+bool eeprom_is_ready() { return eepromState.busyUntilUs <= state.nowUs; }
@@ -0,0 +1,119 @@
+#pragma once
+
+// Host simulation runtime: the knobs a host driver uses to feed the firmware
+// (serial bytes, pin levels, time) and to observe it (serial output, frames).
+//
+// Time is fully simulated. Nothing advances the clock except the driver
+// (advanceUs, paceRealtime) and modeled costs: blocking serial writes and
+// WS2812 show().
+//
+// Everything but the EEPROM is per thread: each thread that touches the
+// runtime gets its own clock, pins, serial ports, frame hook and battery.
+
+#include <stdint.h>
+
+namespace Host {
+
+// ----------------------------
+// Simulated clock
+// ----------------------------
+uint64_t nowUs();
+void advanceUs(uint64_t us);
+
+// ----------------------------
+// Serial
+// ----------------------------
+struct SerialModel {
+  // Time to shift one byte out. ~1042us is a 9600 baud UART; 0 models a host
+  // that drains USB CDC instantly.
+  uint32_t txByteUs = 1042;
+  // Bytes the port can buffer before write() blocks.
+  uint16_t txFifoBytes = 64;
+  // CPU cost of one Serial.read().
+  uint16_t rxReadUs = 2;
+};
+
+// Ports: 0 = Serial (USB), 1 = Serial1 (hardware UART).
+static constexpr uint8_t kSerialPorts = 2;
+
+void setSerialModel(const SerialModel &model, uint8_t port = 0);
+
+// Queue a byte that becomes readable at simulated time atUs.
+void pushSerialRx(uint8_t b, uint64_t atUs, uint8_t port = 0);
+void pushSerialRx(const char *s, uint64_t atUs, uint8_t port = 0);
+void clearSerialRx(uint8_t port = 0);
+uint32_t pendingSerialRx(uint8_t port = 0);
+
+using SerialTxSink = void (*)(uint8_t b, void *user);
+void setSerialTxSink(SerialTxSink sink, void *user, uint8_t port = 0);
+uint64_t serialTxBytes(uint8_t port = 0);
+
+// ----------------------------
+// Pins
+// ----------------------------
+// Inputs default to HIGH (idle level with INPUT_PULLUP).
+void setPinLevel(uint8_t pin, bool high);
+
+// ----------------------------
+// LED output
+// ----------------------------
+// Modeled WS2812 show() duration: 24 bits x 1.25us per pixel, after whatever
+// is left of the driver's latch (Ws2812::kLatchUs since the last frame ended).
+static constexpr uint32_t kShowUsPerPixel = 30;
+
+// Called on every show() with the frame's start time and the post-brightness
+// RGB bytes (3 per pixel, ring order).
+using FrameHook = void (*)(uint64_t atUs, const uint8_t *rgb, uint16_t count, void *user);
+void setFrameHook(FrameHook hook, void *user);
+
+// ----------------------------
+// EEPROM
+// ----------------------------
+// ATmega32U4: 1KB, ~3.4ms per byte write. Starts erased (0xFF).
+static constexpr uint16_t kEepromBytes = 1024;
+static constexpr uint32_t kEepromWriteUs = 3400;
+
+// Raw contents, e.g. to carry them from one simulated power cycle to the next.
+uint8_t *eeprom();
+// Byte writes per address since start (EEPROM cells wear out after ~100k).
+uint32_t eepromWriteCount(uint16_t addr);
+
+// ----------------------------
+// Battery (bandgap ADC)
+// ----------------------------
+// Vcc is replayed from a discharge curve as charge is drawn: the board's own
+// current plus the LED current of the frame being shown. The ADC stand-in
+// returns what the bandgap conversion would read at that Vcc (+-1 LSB noise).
+// Without a curve Vcc is a steady 5V (USB).
+struct BatteryModel {
+  uint16_t capacityMah = 400;
+  // Cell voltage from full to empty, evenly spaced in charge drawn.
+  const uint16_t *curveMv = nullptr;
+  uint8_t curvePoints = 0;
+  float boardMa = 12.0f;          // MCU, regulator, power LED
+  float ledMaPerChannel = 20.0f;  // one WS2812 channel at 255
+  float ledIdleMa = 0.6f;         // per WS2812, even when dark
+  uint16_t bandgapMv = 1100;      // this chip's actual bandgap
+};
+
+// One conversion at the core's ADC clock (16MHz / 128, 13 cycles).
+static constexpr uint32_t kAdcConversionUs = 104;
+
+// Installs a fresh (full) battery.
+void setBattery(const BatteryModel &model);
+double batteryUsedMah();
+uint16_t batteryMv();
+
+// ----------------------------
+// Real time
+// ----------------------------
+// For running the firmware against real I/O (serial_bench --pty): moves the
+// clock to the wall-clock time since the first call, or sleeps while modeled
+// costs have put it ahead. Call once per loop() pass.
+void paceRealtime();
+
+// Restore clock, serial and pins to power-on state. EEPROM contents and wear
+// counts are kept, and so is the battery's charge.
+void reset();
+
+} // namespace Host
@@ -0,0 +1,385 @@
+// Host tool: render a mode offline, as fast as the CPU allows.
+//
+// Runs one LedRingController on the simulated clock (update() every 1ms, as
+// the frame task does) and writes what the ring shows:
+//   --ppm DIR    image sequence DIR/frame_00000.ppm ... at a fixed frame rate,
+//                LEDs drawn on the real ring layout (LED1 top-right, clockwise)
+//   --dump FILE  every show() as a binary record (format below)
+//   --trace FILE every show() as a compact frame trace (frame_trace.h), for
+//                long runs; the trace tool reads it
+// With neither, it only renders, which is the throughput number to watch when
+// changing effect code.
+//
+// The mode starts cold, as at power-on. --from MODE starts in MODE instead and
+// switches at --switch MS (default 1000), to show the mode crossfade;
+// --no-crossfade cuts hard for comparison. Either way the blend's cost per
+// show() is timed and reported.
+//
+// It also reports output levels: every channel of every frame is binned by the
+// level it asked the driver for (8.8, color x brightness) and the shown values
+// averaged per bin. "requested" counts distinct requests and "effective"
+// distinct averages, both at 1/16 of an output step; without dithering the
+// averages collapse onto whole steps. --no-dither turns dithering off for
+// every mode, for the before/after comparison. Blended frames are left out.
+//
+// Binary dump: 8-byte header "TCFD", version (1), pixel count, 2 reserved
+// bytes; then one record per show(): uint32 little-endian time in ms followed
+// by pixel count x R,G,B (post-brightness, LED1 first).
+//
+// Usage: render <mode> [seconds] [--ppm DIR] [--fps N] [--size PX] [--gain G]
+//                      [--dump FILE] [--trace FILE] [--no-dither]
+//                      [--from MODE] [--switch MS] [--no-crossfade]
+//   mode: 1-7 or idle|peace|warning|danger|green|yellow|red
+
+#include <Arduino.h>
+
+#include "frame_trace.h"
+#include "host_runtime.h"
+#include "led_ring.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Options {
+  LedMode mode = LedMode::Danger;
+  uint32_t seconds = 10;
+  const char *ppmDir = nullptr;
+  const char *dumpPath = nullptr;
+  const char *tracePath = nullptr;
+  uint32_t fps = 50;
+  uint32_t size = 128;
+  // Scale output so a full channel at StripBrightness is full scale in the
+  // image; 1 shows the raw (dim) WS2812 values.
+  double gain = 255.0 / (STRIP_BRIGHTNESS + 1);
+  bool dither = true;
+  bool hasFrom = false;
+  LedMode from = LedMode::Idle;
+  uint32_t switchMs = 1000;
+  bool crossfade = true;
+};
+
+struct LevelBin {
+  uint64_t shownSum = 0;
+  uint32_t frames = 0;
+};
+
+struct Render {
+  uint8_t rgb[PIXEL_COUNT * 3] = {};
+  uint64_t shows = 0;
+  uint64_t blended = 0;
+  FILE *dump = nullptr;
+  FrameTrace::Writer *trace = nullptr;
+  const PixelStrip *strip = nullptr;
+  std::vector<LevelBin> levels = std::vector<LevelBin>(65536); // by requested 8.8 level
+};
+
+Render render;
+
+bool parseMode(const char *s, LedMode &out) {
+  static const char *const names[] = {"idle", "peace", "warning", "danger", "green", "yellow", "red"};
+  for (uint8_t i = 0; i < 7; i++) {
+    if (std::strcmp(s, names[i]) == 0 || (s[0] == (char)('1' + i) && s[1] == '\0')) {
+      out = static_cast<LedMode>(i + 1);
+      return true;
+    }
+  }
+  return false;
+}
+
+void onFrame(uint64_t atUs, const uint8_t *rgb, uint16_t count, void *user) {
+  (void)user;
+  std::memcpy(render.rgb, rgb, (size_t)count * 3);
+  render.shows++;
+  if (render.dump) {
+    const uint32_t ms = (uint32_t)(atUs / 1000);
+    const uint8_t t[4] = {(uint8_t)ms, (uint8_t)(ms >> 8), (uint8_t)(ms >> 16), (uint8_t)(ms >> 24)};
+    std::fwrite(t, 1, sizeof(t), render.dump);
+    std::fwrite(rgb, 1, (size_t)count * 3, render.dump);
+  }
+  if (render.trace) {
+    render.trace->add(atUs, rgb);
+  }
+  if (render.strip->holdingFrame()) {
+    render.blended++;
+    return;
+  }
+
+  // Same scaling as Ws2812::outputByte(), before the fraction is dropped.
+  const uint16_t level = render.strip->getBrightnessFine();
+  for (uint16_t i = 0; i < count; i++) {
+    const uint32_t c = render.strip->getPixelColor(i);
+    const uint8_t want[3] = {(uint8_t)(c >> 16), (uint8_t)(c >> 8), (uint8_t)c};
+    for (uint8_t ch = 0; ch < 3; ch++) {
+      const uint8_t v = want[ch];
+      const uint16_t request = (uint16_t)(v * (level >> 8) + ((v * (level & 0xFF)) >> 8) + v);
+      LevelBin &bin = render.levels[request];
+      bin.shownSum += rgb[i * 3 + ch];
+      bin.frames++;
+    }
+  }
+}
+
+void printLevels() {
+  std::vector<bool> requested(4096), effective(4096);
+  uint32_t requestedCount = 0, effectiveCount = 0;
+  double errorSum = 0;
+  uint64_t frames = 0;
+  for (uint32_t r = 256; r < render.levels.size(); r++) { // below one step is dark either way
+    const LevelBin &bin = render.levels[r];
+    if (bin.frames == 0) {
+      continue;
+    }
+    const double shown = (double)bin.shownSum / bin.frames;
+    const uint32_t rq = (r + 8) / 16;
+    const uint32_t ef = (uint32_t)(shown * 16 + 0.5);
+    requestedCount += requested[rq] ? 0 : 1;
+    effectiveCount += effective[ef] ? 0 : 1;
+    requested[rq] = true;
+    effective[ef] = true;
+    errorSum += std::fabs(shown - r / 256.0) * bin.frames;
+    frames += bin.frames;
+  }
+  std::printf("Output levels (1/16 step, dither %s): requested=%u effective=%u, mean error %.3f steps\n",
+              render.strip->getDither() ? "on" : "off", requestedCount, effectiveCount,
+              frames ? errorSum / frames : 0.0);
+}
+
+// Which LED (and how strongly) covers each image pixel. LEDs are placed by
+// the firmware's own geometry table, so Config::RingRotation shows; at 0 with
+// 8 LEDs, LED1 is just right of the top and LED8 just left of it.
+struct Layout {
+  uint32_t size;
+  std::vector<int8_t> led;    // -1 = background
+  std::vector<uint8_t> cover; // 0-255, soft edge
+
+  explicit Layout(uint32_t px) : size(px), led((size_t)px * px, -1), cover((size_t)px * px, 0) {
+    const double c = px / 2.0;
+    const double ringR = px * 0.36;
+    const double ledR = px * 0.11;
+    for (uint16_t i = 0; i < PIXEL_COUNT; i++) {
+      const double a = 2.0 * M_PI * Geometry::Ring<Config>::angle(i) / 256;
+      const double lx = c + ringR * std::sin(a);
+      const double ly = c - ringR * std::cos(a);
+      for (uint32_t y = 0; y < px; y++) {
+        for (uint32_t x = 0; x < px; x++) {
+          const double d = std::hypot(x + 0.5 - lx, y + 0.5 - ly);
+          const double w = std::min(1.0, std::max(0.0, ledR - d + 0.5));
+          const size_t k = (size_t)y * px + x;
+          if (w > 0.0 && (uint8_t)(w * 255) > cover[k]) {
+            led[k] = (int8_t)i;
+            cover[k] = (uint8_t)(w * 255);
+          }
+        }
+      }
+    }
+  }
+};
+
+bool writePpm(const std::string &path, const Layout &layout, const uint8_t *rgb, double gain) {
+  FILE *f = std::fopen(path.c_str(), "wb");
+  if (!f) {
+    std::perror(path.c_str());
+    return false;
+  }
+  std::fprintf(f, "P6\n%u %u\n255\n", layout.size, layout.size);
+  std::vector<uint8_t> row((size_t)layout.size * 3);
+  for (uint32_t y = 0; y < layout.size; y++) {
+    for (uint32_t x = 0; x < layout.size; x++) {
+      const size_t k = (size_t)y * layout.size + x;
+      uint8_t *out = &row[(size_t)x * 3];
+      const int led = layout.led[k];
+      for (uint8_t ch = 0; ch < 3; ch++) {
+        if (led < 0) {
+          out[ch] = 8;
+          continue;
+        }
+        // Unlit LEDs stay faintly visible so the ring geometry reads.
+        const double lit = std::min(255.0, rgb[led * 3 + ch] * gain);
+        out[ch] = (uint8_t)(std::max(lit, 28.0) * layout.cover[k] / 255.0);
+      }
+    }
+    std::fwrite(row.data(), 1, row.size(), f);
+  }
+  return std::fclose(f) == 0;
+}
+
+// Host time per show() of the current strip contents with and without a held
+// frame to blend against. The frame hook is off, so this is the driver's own
+// per-byte pass; docs/WS2812_DRIVER.md has the AVR cycle estimate.
+void timeBlend(double &plainNs, double &blendedNs) {
+  constexpr uint32_t kShows = 200000;
+  PixelStrip strip;
+  for (uint16_t i = 0; i < PIXEL_COUNT; i++) {
+    strip.setPixelColor(i, (uint8_t)(i * 37), (uint8_t)(i * 91), (uint8_t)(255 - i * 13));
+  }
+  strip.setBrightness(STRIP_BRIGHTNESS);
+  Host::setFrameHook(nullptr, nullptr);
+  for (uint8_t pass = 0; pass < 2; pass++) {
+    if (pass == 1) {
+      strip.holdFrame();
+      strip.setPixelColor(0, 0xFFFFFF);
+    }
+    const auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < kShows; i++) {
+      strip.setMix((uint8_t)i);
+      strip.show();
+    }
+    const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    (pass == 0 ? plainNs : blendedNs) = ns / kShows;
+  }
+}
+
+int usage(const char *argv0) {
+  std::fprintf(stderr,
+               "usage: %s <mode 1-7|idle|peace|warning|danger|green|yellow|red> [seconds]\n"
+               "          [--ppm DIR] [--fps N] [--size PX] [--gain G] [--dump FILE] [--trace FILE]\n"
+               "          [--no-dither] [--from MODE] [--switch MS] [--no-crossfade]\n",
+               argv0);
+  return 2;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  Options opt;
+  if (argc < 2 || !parseMode(argv[1], opt.mode)) {
+    return usage(argv[0]);
+  }
+  int argi = 2;
+  if (argi < argc && argv[argi][0] != '-') {
+    opt.seconds = (uint32_t)std::strtoul(argv[argi++], nullptr, 10);
+  }
+  for (; argi < argc; argi++) {
+    const bool hasValue = argi + 1 < argc;
+    if (std::strcmp(argv[argi], "--ppm") == 0 && hasValue) {
+      opt.ppmDir = argv[++argi];
+    } else if (std::strcmp(argv[argi], "--dump") == 0 && hasValue) {
+      opt.dumpPath = argv[++argi];
+    } else if (std::strcmp(argv[argi], "--trace") == 0 && hasValue) {
+      opt.tracePath = argv[++argi];
+    } else if (std::strcmp(argv[argi], "--fps") == 0 && hasValue) {
+      opt.fps = (uint32_t)std::strtoul(argv[++argi], nullptr, 10);
+    } else if (std::strcmp(argv[argi], "--size") == 0 && hasValue) {
+      opt.size = (uint32_t)std::strtoul(argv[++argi], nullptr, 10);
+    } else if (std::strcmp(argv[argi], "--gain") == 0 && hasValue) {
+      opt.gain = std::atof(argv[++argi]);
+    } else if (std::strcmp(argv[argi], "--no-dither") == 0) {
+      opt.dither = false;
+    } else if (std::strcmp(argv[argi], "--from") == 0 && hasValue) {
+      opt.hasFrom = parseMode(argv[++argi], opt.from);
+      if (!opt.hasFrom) {
+        return usage(argv[0]);
+      }
+    } else if (std::strcmp(argv[argi], "--switch") == 0 && hasValue) {
+      opt.switchMs = (uint32_t)std::strtoul(argv[++argi], nullptr, 10);
+    } else if (std::strcmp(argv[argi], "--no-crossfade") == 0) {
+      opt.crossfade = false;
+    } else {
+      return usage(argv[0]);
+    }
+  }
+  if (opt.seconds == 0 || opt.fps == 0 || opt.fps > 1000 || opt.size < 16) {
+    return usage(argv[0]);
+  }
+
+  if (opt.dumpPath) {
+    render.dump = std::fopen(opt.dumpPath, "wb");
+    if (!render.dump) {
+      std::perror(opt.dumpPath);
+      return 1;
+    }
+    const uint8_t header[8] = {'T', 'C', 'F', 'D', 1, (uint8_t)PIXEL_COUNT, 0, 0};
+    std::fwrite(header, 1, sizeof(header), render.dump);
+  }
+  FrameTrace::Writer trace;
+  if (opt.tracePath) {
+    if (!trace.open(opt.tracePath, PIXEL_COUNT)) {
+      std::perror(opt.tracePath);
+      return 1;
+    }
+    render.trace = &trace;
+  }
+  const std::unique_ptr<const Layout> layout(opt.ppmDir ? new Layout(opt.size) : nullptr);
+
+  PixelStrip strip;
+  LedRingController ring(strip);
+  render.strip = &strip;
+  Host::setFrameHook(onFrame, nullptr);
+
+  const auto wallStart = std::chrono::steady_clock::now();
+
+  ring.begin();
+  ring.setDitherEnabled(opt.dither);
+  ring.setCrossfadeEnabled(false); // cold start: nothing to fade from
+  ring.setMode(opt.hasFrom ? opt.from : opt.mode, true);
+  ring.setCrossfadeEnabled(opt.crossfade);
+
+  const uint64_t endUs = (uint64_t)opt.seconds * 1000000;
+  const uint64_t imageUs = 1000000 / opt.fps;
+  uint64_t nextImageUs = 0;
+  uint32_t images = 0;
+  char name[32];
+
+  for (uint64_t tickUs = 0; tickUs < endUs; tickUs += 1000) {
+    if (Host::nowUs() < tickUs) {
+      Host::advanceUs(tickUs - Host::nowUs());
+    }
+    if (opt.hasFrom && tickUs == (uint64_t)opt.switchMs * 1000) {
+      ring.setMode(opt.mode, true);
+    }
+    ring.update(millis());
+
+    while (layout && nextImageUs <= tickUs) {
+      std::snprintf(name, sizeof(name), "/frame_%05u.ppm", images);
+      if (!writePpm(std::string(opt.ppmDir) + name, *layout, render.rgb, opt.gain)) {
+        return 1;
+      }
+      images++;
+      nextImageUs += imageUs;
+    }
+  }
+
+  if (render.dump && std::fclose(render.dump) != 0) {
+    std::perror(opt.dumpPath);
+    return 1;
+  }
+  if (render.trace && !trace.close()) {
+    std::perror(opt.tracePath);
+    return 1;
+  }
+  const double wallS =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+
+  std::printf("Rendered mode %u for %us: %llu shows", static_cast<unsigned>(opt.mode), opt.seconds,
+              (unsigned long long)render.shows);
+  if (layout) {
+    std::printf(", %u images (%ux%u @ %ufps) in %s", images, opt.size, opt.size, opt.fps, opt.ppmDir);
+  }
+  if (opt.dumpPath) {
+    std::printf(", dump %s", opt.dumpPath);
+  }
+  if (opt.tracePath) {
+    std::printf(", trace %s (%llu bytes)", opt.tracePath, (unsigned long long)trace.bytes());
+  }
+  if (opt.hasFrom) {
+    std::printf(", from mode %u at %ums", static_cast<unsigned>(opt.from), opt.switchMs);
+  }
+  std::printf("\nWall time %.3fs: %.0fx realtime, %.0f shows/s, %.0f updates/s\n", wallS, opt.seconds / wallS,
+              render.shows / wallS, opt.seconds * 1000.0 / wallS);
+  printLevels();
+
+  double plainNs = 0, blendedNs = 0;
+  timeBlend(plainNs, blendedNs);
+  std::printf("Crossfade (%ums, %s): %llu blended shows; show() %.0fns, %.0fns blended (+%.1fns/byte)\n",
+              Config::ModeCrossfadeMs, opt.crossfade ? "on" : "off", (unsigned long long)render.blended, plainNs,
+              blendedNs, (blendedNs - plainNs) / (PIXEL_COUNT * 3));
+  return 0;
+}
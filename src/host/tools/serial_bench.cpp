@@ -0,0 +1,324 @@
+// Host tool: serial command-to-acknowledgement latency.
+//
+// Sends mode commands ('1'-'4') at a fixed rate and times each one until the
+// firmware acknowledges it (Config::SerialModeAck: 0x06 followed by the
+// command, sent once the new mode's first frame has been shown). Reports
+// p50/p99/max per command. The far end is either
+//   --device PATH  a collar on a serial port (e.g. /dev/ttyACM0), or
+//   --pty          this firmware build, host-native and paced to real time,
+//                  on the other side of a pseudo-terminal (no hardware needed)
+//
+// Commands go out open-loop at --rate, cycling through --modes. A command
+// overtaken by the next one before its frame is never acknowledged by the
+// firmware; those are counted as superseded, anything else unanswered after
+// --timeout-ms as lost.
+//
+// Usage: serial_bench (--device PATH | --pty) [--rate N] [--count N]
+//                     [--modes CHARS] [--timeout-ms N] [--baud N]
+
+#include <Arduino.h>
+
+#include "config.h"
+#include "host_runtime.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr uint8_t kAckByte = 0x06;
+constexpr uint64_t kLoopPassUs = 8; // modeled cost of one loop() pass
+constexpr uint32_t kWarmupMs = 1000; // boot banner, USB enumeration
+
+struct Options {
+  const char *device = nullptr;
+  bool pty = false;
+  double rate = 10.0;
+  uint32_t count = 200;
+  std::string modes = "42";
+  uint32_t timeoutMs = 1000;
+  uint32_t baud = Config::SerialBaud;
+};
+
+speed_t speedOf(uint32_t baud) {
+  switch (baud) {
+    case 9600:
+      return B9600;
+    case 19200:
+      return B19200;
+    case 38400:
+      return B38400;
+    case 57600:
+      return B57600;
+    case 115200:
+      return B115200;
+    default:
+      return B0;
+  }
+}
+
+bool setRaw(int fd, uint32_t baud) {
+  termios t;
+  if (tcgetattr(fd, &t) != 0) {
+    return false;
+  }
+  cfmakeraw(&t);
+  t.c_cc[VMIN] = 0;
+  t.c_cc[VTIME] = 0;
+  cfsetispeed(&t, speedOf(baud));
+  cfsetospeed(&t, speedOf(baud));
+  return tcsetattr(fd, TCSANOW, &t) == 0;
+}
+
+// ---- far end of the pty: the firmware ----
+
+int firmwareFd = -1;
+
+void txToPty(uint8_t b, void *user) {
+  (void)user;
+  if (::write(firmwareFd, &b, 1) != 1) {
+    _exit(0); // bench side closed
+  }
+}
+
+[[noreturn]] void runFirmware(int fd) {
+  firmwareFd = fd;
+  Host::SerialModel usb;
+  usb.txByteUs = 0; // USB CDC: the host drains it as fast as it can
+  Host::setSerialModel(usb);
+  Host::setSerialTxSink(txToPty, nullptr);
+
+  setup();
+  for (;;) {
+    pollfd p = {fd, POLLIN, 0};
+    while (poll(&p, 1, 0) > 0) {
+      uint8_t buf[64];
+      const ssize_t n = ::read(fd, buf, sizeof(buf));
+      if (n <= 0) {
+        _exit(0);
+      }
+      for (ssize_t i = 0; i < n; i++) {
+        Host::pushSerialRx(buf[i], Host::nowUs());
+      }
+    }
+    loop();
+    Host::advanceUs(kLoopPassUs);
+    Host::paceRealtime();
+  }
+}
+
+// Master side of a new pty, with the firmware running on the slave side.
+int startPtyFirmware(uint32_t baud, pid_t &child) {
+  const int master = posix_openpt(O_RDWR | O_NOCTTY);
+  if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+    std::perror("posix_openpt");
+    return -1;
+  }
+  const int slave = ::open(ptsname(master), O_RDWR | O_NOCTTY);
+  if (slave < 0 || !setRaw(slave, baud)) {
+    std::perror("pty slave");
+    return -1;
+  }
+
+  child = fork();
+  if (child < 0) {
+    std::perror("fork");
+    return -1;
+  }
+  if (child == 0) {
+    close(master);
+    runFirmware(slave);
+  }
+  close(slave);
+  return master;
+}
+
+// ---- bench side ----
+
+struct Sent {
+  char command;
+  Clock::time_point at;
+};
+
+struct Results {
+  std::vector<double> latencyMs[256];
+  std::vector<double> allMs;
+  uint32_t acked = 0;
+  uint32_t superseded = 0;
+  uint32_t lost = 0;
+  uint32_t stray = 0;
+};
+
+void onAck(char command, Clock::time_point at, std::deque<Sent> &waiting, Results &r) {
+  const auto it =
+      std::find_if(waiting.begin(), waiting.end(), [command](const Sent &s) { return s.command == command; });
+  if (it == waiting.end()) {
+    r.stray++;
+    return;
+  }
+  // The firmware only acknowledges the newest command; anything older that is
+  // still waiting was overtaken.
+  r.superseded += (uint32_t)(it - waiting.begin());
+  const double ms = std::chrono::duration<double, std::milli>(at - it->at).count();
+  r.latencyMs[(uint8_t)command].push_back(ms);
+  r.allMs.push_back(ms);
+  r.acked++;
+  waiting.erase(waiting.begin(), it + 1);
+}
+
+double percentile(std::vector<double> v, double q) {
+  if (v.empty()) {
+    return 0.0;
+  }
+  std::sort(v.begin(), v.end());
+  return v[(size_t)(q * (double)(v.size() - 1))];
+}
+
+void printRow(const char *label, const std::vector<double> &v) {
+  std::printf("%-8s %6zu %9.2fms %9.2fms %9.2fms\n", label, v.size(), percentile(v, 0.5), percentile(v, 0.99),
+              v.empty() ? 0.0 : *std::max_element(v.begin(), v.end()));
+}
+
+void bench(int fd, const Options &opt, Results &r) {
+  bool afterAck = false;
+  auto drain = [&](std::deque<Sent> &waiting, int timeoutMs) {
+    pollfd p = {fd, POLLIN, 0};
+    if (poll(&p, 1, timeoutMs) <= 0 || !(p.revents & POLLIN)) {
+      return;
+    }
+    uint8_t buf[256];
+    const ssize_t n = ::read(fd, buf, sizeof(buf));
+    const Clock::time_point at = Clock::now();
+    for (ssize_t i = 0; i < n; i++) {
+      if (afterAck) {
+        onAck((char)buf[i], at, waiting, r);
+      }
+      afterAck = buf[i] == kAckByte;
+    }
+  };
+
+  std::deque<Sent> waiting;
+  const Clock::time_point warmupEnd = Clock::now() + std::chrono::milliseconds(kWarmupMs);
+  while (Clock::now() < warmupEnd) {
+    drain(waiting, 10);
+  }
+  r.stray = 0;
+
+  const auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / opt.rate));
+  const auto timeout = std::chrono::milliseconds(opt.timeoutMs);
+  Clock::time_point nextSend = Clock::now();
+  uint32_t sent = 0;
+  while (sent < opt.count || !waiting.empty()) {
+    const Clock::time_point now = Clock::now();
+    while (!waiting.empty() && now - waiting.front().at > timeout) {
+      r.lost++;
+      waiting.pop_front();
+    }
+    if (sent < opt.count && now >= nextSend) {
+      const char c = opt.modes[sent % opt.modes.size()];
+      if (::write(fd, &c, 1) != 1) {
+        std::perror("write");
+        return;
+      }
+      waiting.push_back(Sent{c, Clock::now()});
+      sent++;
+      nextSend += period;
+      continue;
+    }
+    drain(waiting, 1);
+  }
+}
+
+int usage(const char *argv0) {
+  std::fprintf(stderr,
+               "usage: %s (--device PATH | --pty) [--rate N] [--count N] [--modes CHARS]\n"
+               "          [--timeout-ms N] [--baud N]\n",
+               argv0);
+  return 2;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  Options opt;
+  for (int argi = 1; argi < argc; argi++) {
+    const bool hasValue = argi + 1 < argc;
+    if (std::strcmp(argv[argi], "--device") == 0 && hasValue) {
+      opt.device = argv[++argi];
+    } else if (std::strcmp(argv[argi], "--pty") == 0) {
+      opt.pty = true;
+    } else if (std::strcmp(argv[argi], "--rate") == 0 && hasValue) {
+      opt.rate = std::atof(argv[++argi]);
+    } else if (std::strcmp(argv[argi], "--count") == 0 && hasValue) {
+      opt.count = (uint32_t)std::strtoul(argv[++argi], nullptr, 10);
+    } else if (std::strcmp(argv[argi], "--modes") == 0 && hasValue) {
+      opt.modes = argv[++argi];
+    } else if (std::strcmp(argv[argi], "--timeout-ms") == 0 && hasValue) {
+      opt.timeoutMs = (uint32_t)std::strtoul(argv[++argi], nullptr, 10);
+    } else if (std::strcmp(argv[argi], "--baud") == 0 && hasValue) {
+      opt.baud = (uint32_t)std::strtoul(argv[++argi], nullptr, 10);
+    } else {
+      return usage(argv[0]);
+    }
+  }
+  const bool modesOk = !opt.modes.empty() && opt.modes.find_first_not_of("1234") == std::string::npos;
+  if ((opt.device != nullptr) == opt.pty || opt.rate <= 0.0 || opt.count == 0 || !modesOk ||
+      speedOf(opt.baud) == B0) {
+    return usage(argv[0]);
+  }
+
+  pid_t child = -1;
+  int fd = -1;
+  if (opt.pty) {
+    fd = startPtyFirmware(opt.baud, child);
+  } else {
+    fd = ::open(opt.device, O_RDWR | O_NOCTTY);
+    if (fd < 0 || !setRaw(fd, opt.baud)) {
+      std::perror(opt.device);
+      return 1;
+    }
+  }
+  if (fd < 0) {
+    return 1;
+  }
+
+  Results r;
+  bench(fd, opt, r);
+  close(fd);
+  if (child > 0) {
+    kill(child, SIGTERM);
+    waitpid(child, nullptr, 0);
+  }
+
+  std::printf("%s: %u commands at %.1f/s, modes \"%s\"\n", opt.pty ? "pty (host firmware, real time)" : opt.device,
+              opt.count, opt.rate, opt.modes.c_str());
+  std::printf("Acked %u, superseded %u, lost %u", r.acked, r.superseded, r.lost);
+  if (r.stray != 0) {
+    std::printf(", stray acks %u", r.stray);
+  }
+  std::printf("\n\n%-8s %6s %11s %11s %11s\n", "command", "n", "p50", "p99", "max");
+  char label[8];
+  for (const char c : std::string("1234")) {
+    if (!r.latencyMs[(uint8_t)c].empty()) {
+      std::snprintf(label, sizeof(label), "'%c'", c);
+      printRow(label, r.latencyMs[(uint8_t)c]);
+    }
+  }
+  printRow("all", r.allMs);
+  return r.acked != 0 ? 0 : 1;
+}
@@ -0,0 +1,166 @@
+// Host simulation: runtime on a battery, fixed vs battery-aware duty cycle.
+//
+// Drives one LedRingController on the simulated clock (update() every 1ms, as
+// the frame task does) from a full battery until the cell reaches the cutoff
+// voltage. The host battery model replays a discharge curve against the charge
+// actually drawn (board current + LED current of each frame shown). Each mode
+// runs twice:
+//   fixed    - today's constants, no sampling
+//   adaptive - Battery::Monitor sampled every BatterySampleMs, policy applied
+//              on tier changes, as the firmware's battery task does
+//
+// Usage: sim_battery [mode|all] [capacity_mAh] [--curve FILE] [--cutoff MV]
+//   mode: peace|warning|danger|green|yellow|red
+//   FILE: one cell voltage (mV) per line, full to empty, evenly spaced in charge
+
+#include <Arduino.h>
+
+#include "battery.h"
+#include "host_runtime.h"
+#include "led_ring.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+// Typical 1S LiPo at a light (<0.2C) load, 0% to 100% of capacity drawn.
+const uint16_t kLiPoCurveMv[] = {4200, 4080, 3990, 3930, 3880, 3840, 3800, 3770, 3730, 3670, 3300};
+
+constexpr uint64_t kMaxHours = 200;
+
+struct Result {
+  double hours = 0.0;
+  double avgMa = 0.0;
+  double tierHours[3] = {};
+};
+
+Result run(LedMode mode, bool adaptive, const Host::BatteryModel &model, uint16_t cutoffMv) {
+  Host::reset();
+  Host::setBattery(model);
+
+  PixelStrip strip;
+  LedRingController ring(strip);
+  Battery::Monitor monitor;
+  Battery::begin();
+  ring.begin();
+  ring.setMode(mode, true);
+
+  Result r;
+  uint64_t ms = 0;
+  uint64_t nextSampleMs = Config::BatterySampleMs;
+  const uint64_t maxMs = kMaxHours * 3600000ull;
+  for (; ms < maxMs; ms++) {
+    if (Host::nowUs() < ms * 1000) {
+      Host::advanceUs(ms * 1000 - Host::nowUs());
+    }
+    ring.update(millis());
+
+    if (ms == nextSampleMs) {
+      nextSampleMs += Config::BatterySampleMs;
+      if (Host::batteryMv() < cutoffMv) {
+        break;
+      }
+      if (adaptive && monitor.addSample(Battery::readBandgap())) {
+        ring.setPowerPolicy(Battery::policyFor(monitor.tier()));
+      }
+      r.tierHours[static_cast<uint8_t>(monitor.tier())] += Config::BatterySampleMs / 3600000.0;
+    }
+  }
+  r.hours = ms / 3600000.0;
+  r.avgMa = Host::batteryUsedMah() / r.hours;
+  return r;
+}
+
+bool loadCurve(const char *path, std::vector<uint16_t> &out) {
+  FILE *f = std::fopen(path, "r");
+  if (!f) {
+    std::perror(path);
+    return false;
+  }
+  unsigned mv = 0;
+  while (std::fscanf(f, "%u", &mv) == 1) {
+    out.push_back((uint16_t)mv);
+  }
+  std::fclose(f);
+  return out.size() >= 2 && out.size() <= 255;
+}
+
+int usage(const char *argv0) {
+  std::fprintf(stderr, "usage: %s [peace|warning|danger|green|yellow|red|all] [capacity_mAh] [--curve FILE] [--cutoff MV]\n",
+               argv0);
+  return 2;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  struct ModeName {
+    const char *name;
+    LedMode mode;
+  };
+  static const ModeName kModes[] = {
+      {"peace", LedMode::Peace},      {"warning", LedMode::Warning},     {"danger", LedMode::Danger},
+      {"green", LedMode::SolidGreen}, {"yellow", LedMode::SolidYellow}, {"red", LedMode::SolidRed},
+  };
+
+  std::vector<const ModeName *> modes;
+  Host::BatteryModel model;
+  std::vector<uint16_t> curve(kLiPoCurveMv, kLiPoCurveMv + sizeof(kLiPoCurveMv) / sizeof(kLiPoCurveMv[0]));
+  uint16_t cutoffMv = 3400;
+
+  int argi = 1;
+  if (argi < argc && argv[argi][0] != '-') {
+    const char *m = argv[argi++];
+    for (const ModeName &mn : kModes) {
+      if (std::strcmp(m, mn.name) == 0) {
+        modes.push_back(&mn);
+      }
+    }
+    if (modes.empty() && std::strcmp(m, "all") != 0) {
+      return usage(argv[0]);
+    }
+  }
+  if (argi < argc && argv[argi][0] != '-') {
+    model.capacityMah = (uint16_t)std::strtoul(argv[argi++], nullptr, 10);
+  }
+  for (; argi < argc; argi++) {
+    if (std::strcmp(argv[argi], "--curve") == 0 && argi + 1 < argc) {
+      curve.clear();
+      if (!loadCurve(argv[++argi], curve)) {
+        return usage(argv[0]);
+      }
+    } else if (std::strcmp(argv[argi], "--cutoff") == 0 && argi + 1 < argc) {
+      cutoffMv = (uint16_t)std::strtoul(argv[++argi], nullptr, 10);
+    } else {
+      return usage(argv[0]);
+    }
+  }
+  if (modes.empty()) {
+    for (const ModeName &mn : kModes) {
+      if (mn.mode != LedMode::SolidYellow && mn.mode != LedMode::SolidRed) {
+        modes.push_back(&mn);
+      }
+    }
+  }
+  if (model.capacityMah == 0) {
+    return usage(argv[0]);
+  }
+  model.curveMv = curve.data();
+  model.curvePoints = (uint8_t)curve.size();
+
+  std::printf("Battery %umAh, %u-point curve %u..%umV, cutoff %umV, tiers Low<%umV Critical<%umV\n\n",
+              model.capacityMah, model.curvePoints, curve.front(), curve.back(), cutoffMv, Config::BatteryLowMv,
+              Config::BatteryCriticalMv);
+  std::printf("mode        fixed (h)  avg mA   adaptive (h)  avg mA   gain   h in Normal/Low/Critical\n");
+  for (const ModeName *mn : modes) {
+    const Result fixed = run(mn->mode, false, model, cutoffMv);
+    const Result adaptive = run(mn->mode, true, model, cutoffMv);
+    std::printf("%-10s  %9.2f  %6.1f   %12.2f  %6.1f  %+5.0f%%   %.1f/%.1f/%.1f\n", mn->name, fixed.hours, fixed.avgMa,
+                adaptive.hours, adaptive.avgMa, (adaptive.hours / fixed.hours - 1.0) * 100.0, adaptive.tierHours[0],
+                adaptive.tierHours[1], adaptive.tierHours[2]);
+  }
+  return 0;
+}
@@ -0,0 +1,421 @@
+// Host simulation: a fleet of collars soak-tested in parallel.
+//
+// Each collar is its own Collar instance (include/collar.h) with its own
+// strip, driven by a randomized input trace: remote presses at a per-collar
+// activity level, held for a random time (a few long enough for a long
+// press), some as two-button chords, some with contact bounce, and a battery that starts and sags at its own rate.
+// The trace is a function of the seed and the collar's index only, so a run
+// is reproducible at any thread count.
+//
+// Collars are the work items of a work-stealing thread pool: each worker
+// starts with a contiguous block of collars, runs its own from the back and,
+// when it is out, steals from the front of another worker's block. The whole
+// fleet is run at 1, 2, 4 ... threads up to --threads, reporting simulated
+// collar-seconds per wall-clock second, the speedup over one thread and the
+// steals. The digest (every frame of every collar, in collar order) must be
+// the same at every thread count; a difference means collars share state.
+//
+// Invariants checked on every 1ms step:
+//   Danger  never fades or sleeps, and never goes longer than kDangerGapMs
+//           without a frame
+//   dark    Idle and Sleeping leave the ring blank (once a crossfade into
+//           them has run out)
+//
+// Usage: sim_fleet [--collars N] [--seconds N] [--threads N] [--seed N]
+
+#include <Arduino.h>
+
+#include "collar.h"
+#include "config.h"
+#include "host_runtime.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Longest Danger step is the cop lights' DangerCopStepMs; allow one more.
+constexpr uint32_t kDangerGapMs = 2u * Config::DangerCopStepMs;
+
+struct Options {
+  uint32_t collars = 1000;
+  uint32_t seconds = 60;
+  unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+  uint32_t seed = 1;
+};
+
+// ---- input traces ----
+
+struct Press {
+  uint32_t atMs;
+  uint16_t holdMs;
+  uint8_t bounceMs; // contact chatter at the start of the press
+  uint8_t pins;     // mask; two bits for a chord
+};
+
+struct Trace {
+  std::vector<Press> presses;
+  double startMv;
+  double sagMvPerS;
+};
+
+Trace makeTrace(uint32_t seed, uint32_t index, uint32_t seconds) {
+  std::mt19937 rng(seed * 0x9E3779B9u + index);
+  std::uniform_real_distribution<double> unit(0.0, 1.0);
+  std::uniform_int_distribution<int> pin(0, Collar::kRemoteCount - 1);
+  std::uniform_int_distribution<int> hold(40, 400);
+  std::uniform_int_distribution<int> longHold(Config::RemoteLongPressMs + 50, 1500);
+  std::uniform_int_distribution<int> bounce(1, 4);
+
+  Trace t;
+  // From a handler who checks in every ~20s to one who is on the buttons.
+  const double meanGapMs = 500.0 + 20000.0 * unit(rng) * unit(rng);
+  std::exponential_distribution<double> gap(1.0 / meanGapMs);
+  double at = 1.0;
+  for (;;) {
+    at += 60.0 + gap(rng);
+    if (at >= (double)seconds * 1000.0) {
+      break;
+    }
+    Press p;
+    p.atMs = (uint32_t)at;
+    p.holdMs = (uint16_t)((unit(rng) < 0.05) ? longHold(rng) : hold(rng));
+    p.bounceMs = (uint8_t)((unit(rng) < 0.1) ? bounce(rng) : 0);
+    p.pins = (uint8_t)(1u << pin(rng));
+    if (unit(rng) < 0.05) {
+      p.pins |= (uint8_t)(1u << pin(rng));
+    }
+    t.presses.push_back(p);
+    at += p.holdMs;
+  }
+  t.startMv = 3550.0 + 650.0 * unit(rng);
+  t.sagMvPerS = 1.5 * unit(rng);
+  return t;
+}
+
+// ---- one collar ----
+
+enum Violation : uint8_t {
+  DangerPowerSave,
+  DangerStall,
+  NotDark,
+  kViolationKinds,
+};
+
+const char *const kViolationNames[kViolationKinds] = {"Danger power-saving", "Danger frame gap", "Idle/Sleeping lit"};
+
+struct Result {
+  uint64_t digest = 0xcbf29ce484222325ull; // FNV-1a over frames and mode changes
+  uint32_t frames = 0;
+  uint32_t modesApplied = 0;
+  uint32_t gestures = 0;
+  uint32_t batteryChanges = 0;
+  uint32_t maxDangerGapMs = 0;
+  uint32_t violations[kViolationKinds] = {};
+};
+
+struct Run {
+  Result result;
+  bool lastFrameLit = false;
+};
+
+void mix(uint64_t &h, uint8_t b) {
+  h ^= b;
+  h *= 0x100000001b3ull;
+}
+
+void onFrame(uint64_t atUs, const uint8_t *rgb, uint16_t count, void *user) {
+  (void)atUs;
+  Run &run = *static_cast<Run *>(user);
+  bool lit = false;
+  for (uint16_t i = 0; i < count * 3u; i++) {
+    mix(run.result.digest, rgb[i]);
+    lit = lit || rgb[i] != 0;
+  }
+  run.lastFrameLit = lit;
+  run.result.frames++;
+}
+
+void onModeChange(LedMode mode, Flight::Source source, void *user) {
+  (void)source;
+  Run &run = *static_cast<Run *>(user);
+  mix(run.result.digest, 0x80 | static_cast<uint8_t>(mode));
+  run.result.modesApplied++;
+}
+
+Result runCollar(const Options &opt, uint32_t index) {
+  const Trace trace = makeTrace(opt.seed, index, opt.seconds);
+  Run run;
+  PixelStrip strip;
+  Collar collar(strip, onModeChange, &run);
+  LedRingController &ring = collar.ring();
+
+  // Frame hooks are per thread; this collar has the thread until it is done.
+  Host::setFrameHook(onFrame, &run);
+  ring.begin();
+  ring.setMode(LedMode::Idle);
+
+  bool high[Collar::kRemoteCount];
+  uint32_t downUntil[Collar::kRemoteCount] = {};
+  uint32_t bounceUntil[Collar::kRemoteCount] = {};
+  std::fill(high, high + Collar::kRemoteCount, true);
+  collar.beginRemotes(high);
+
+  size_t next = 0;
+  uint32_t lastFrameMs = 1;
+  uint16_t frames = ring.framesShown();
+  const uint32_t endMs = opt.seconds * 1000u;
+  for (uint32_t ms = 1; ms <= endMs; ms++) {
+    for (; next < trace.presses.size() && trace.presses[next].atMs <= ms; next++) {
+      const Press &p = trace.presses[next];
+      for (uint8_t i = 0; i < Collar::kRemoteCount; i++) {
+        if (p.pins & (1u << i)) {
+          downUntil[i] = ms + p.holdMs;
+          bounceUntil[i] = ms + p.bounceMs;
+        }
+      }
+    }
+    for (uint8_t i = 0; i < Collar::kRemoteCount; i++) {
+      high[i] = (ms < bounceUntil[i]) ? (ms & 1) != 0 : ms >= downUntil[i];
+    }
+
+    const LedMode modeBefore = ring.mode();
+    collar.pollRemotes(high, ms);
+    Collar::Gestures::Fired gesture;
+    while (collar.takeGesture(gesture)) {
+      run.result.gestures++;
+      collar.handleGesture(gesture, ms);
+    }
+    if (Config::BatteryAdaptive && ms % Config::BatterySampleMs == 0) {
+      const double mv = trace.startMv - trace.sagMvPerS * ms / 1000.0;
+      if (collar.addBatterySample((uint16_t)(Config::BandgapMv * 1024.0 / mv), ms)) {
+        run.result.batteryChanges++;
+      }
+    }
+
+    collar.update(ms, ms);
+
+    const LedMode mode = ring.mode();
+    if (ring.framesShown() != frames || mode != modeBefore) {
+      frames = ring.framesShown();
+      lastFrameMs = ms;
+    }
+    if (mode == LedMode::Danger) {
+      run.result.violations[DangerPowerSave] += ring.powerStateValue() != 0;
+      const uint32_t gap = ms - lastFrameMs;
+      run.result.maxDangerGapMs = std::max(run.result.maxDangerGapMs, gap);
+      run.result.violations[DangerStall] += gap == kDangerGapMs + 1;
+    } else if ((mode == LedMode::Idle || ring.powerStateValue() == 2) && !ring.crossfading()) {
+      // Blanked by the first update in that state, or the last of a crossfade.
+      run.result.violations[NotDark] += run.lastFrameLit && ms != lastFrameMs;
+    }
+  }
+
+  Host::setFrameHook(nullptr, nullptr);
+  return run.result;
+}
+
+// ---- work-stealing pool ----
+
+class StealingPool {
+public:
+  explicit StealingPool(unsigned threads) : queues(threads) {
+    for (auto &q : queues) {
+      q.reset(new Queue);
+    }
+  }
+
+  // Runs job(i) for every i in [0, count) and returns the number of steals.
+  // Nothing is queued after the start, so a worker that finds every queue
+  // empty is done.
+  template <typename Job> uint64_t run(uint32_t count, Job job) {
+    const unsigned n = (unsigned)queues.size();
+    for (unsigned w = 0; w < n; w++) {
+      const uint32_t from = (uint32_t)((uint64_t)count * w / n);
+      const uint32_t to = (uint32_t)((uint64_t)count * (w + 1) / n);
+      queues[w]->items.clear();
+      for (uint32_t i = from; i < to; i++) {
+        queues[w]->items.push_back(i);
+      }
+    }
+
+    std::atomic<uint64_t> steals(0);
+    auto worker = [&](unsigned self) {
+      uint32_t item;
+      for (;;) {
+        if (popBack(self, item)) {
+          job(item);
+          continue;
+        }
+        bool stole = false;
+        for (unsigned k = 1; k < n && !stole; k++) {
+          stole = popFront((self + k) % n, item);
+        }
+        if (!stole) {
+          return;
+        }
+        steals++;
+        job(item);
+      }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned w = 1; w < n; w++) {
+      threads.emplace_back(worker, w);
+    }
+    worker(0);
+    for (auto &t : threads) {
+      t.join();
+    }
+    return steals;
+  }
+
+private:
+  struct Queue {
+    std::mutex lock;
+    std::deque<uint32_t> items;
+  };
+
+  bool popBack(unsigned w, uint32_t &item) {
+    Queue &q = *queues[w];
+    std::lock_guard<std::mutex> hold(q.lock);
+    if (q.items.empty()) {
+      return false;
+    }
+    item = q.items.back();
+    q.items.pop_back();
+    return true;
+  }
+
+  bool popFront(unsigned w, uint32_t &item) {
+    Queue &q = *queues[w];
+    std::lock_guard<std::mutex> hold(q.lock);
+    if (q.items.empty()) {
+      return false;
+    }
+    item = q.items.front();
+    q.items.pop_front();
+    return true;
+  }
+
+  std::vector<std::unique_ptr<Queue>> queues;
+};
+
+// ---- report ----
+
+uint64_t fleetDigest(const std::vector<Result> &results) {
+  uint64_t h = 0xcbf29ce484222325ull;
+  for (const Result &r : results) {
+    for (uint8_t i = 0; i < 8; i++) {
+      mix(h, (uint8_t)(r.digest >> (8 * i)));
+    }
+  }
+  return h;
+}
+
+template <typename T> T percentile(std::vector<T> v, double q) {
+  std::sort(v.begin(), v.end());
+  return v.empty() ? T() : v[(size_t)(q * (double)(v.size() - 1))];
+}
+
+int usage(const char *argv0) {
+  std::fprintf(stderr, "usage: %s [--collars N] [--seconds N] [--threads N] [--seed N]\n", argv0);
+  return 2;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  Options opt;
+  for (int argi = 1; argi < argc; argi++) {
+    const bool hasValue = argi + 1 < argc;
+    if (std::strcmp(argv[argi], "--collars") == 0 && hasValue) {
+      opt.collars = (uint32_t)std::strtoul(argv[++argi], nullptr, 10);
+    } else if (std::strcmp(argv[argi], "--seconds") == 0 && hasValue) {
+      opt.seconds = (uint32_t)std::strtoul(argv[++argi], nullptr, 10);
+    } else if (std::strcmp(argv[argi], "--threads") == 0 && hasValue) {
+      opt.threads = (unsigned)std::strtoul(argv[++argi], nullptr, 10);
+    } else if (std::strcmp(argv[argi], "--seed") == 0 && hasValue) {
+      opt.seed = (uint32_t)std::strtoul(argv[++argi], nullptr, 10);
+    } else {
+      return usage(argv[0]);
+    }
+  }
+  if (opt.collars == 0 || opt.seconds == 0 || opt.seconds > 3600 || opt.threads == 0) {
+    return usage(argv[0]);
+  }
+
+  std::vector<unsigned> counts;
+  for (unsigned t = 1; t < opt.threads; t *= 2) {
+    counts.push_back(t);
+  }
+  counts.push_back(opt.threads);
+
+  const double simSeconds = (double)opt.collars * opt.seconds;
+  std::printf("Fleet: %u collars x %us simulated, seed %u, %u hardware threads\n\n", opt.collars, opt.seconds,
+              opt.seed, std::thread::hardware_concurrency());
+  std::printf("%-8s %9s %12s %8s %8s  %s\n", "threads", "wall", "sim-s/s", "speedup", "steals", "digest");
+
+  std::vector<Result> results(opt.collars);
+  uint64_t firstDigest = 0;
+  double oneThreadWall = 0.0;
+  bool digestsMatch = true;
+  for (const unsigned threads : counts) {
+    StealingPool pool(threads);
+    const auto start = std::chrono::steady_clock::now();
+    const uint64_t steals = pool.run(opt.collars, [&](uint32_t i) { results[i] = runCollar(opt, i); });
+    const double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const uint64_t digest = fleetDigest(results);
+    if (threads == counts.front()) {
+      firstDigest = digest;
+      oneThreadWall = wall;
+    }
+    digestsMatch = digestsMatch && digest == firstDigest;
+    std::printf("%-8u %8.2fs %12.0f %7.2fx %8llu  %016llx%s\n", threads, wall, simSeconds / wall, oneThreadWall / wall,
+                (unsigned long long)steals, (unsigned long long)digest, digest == firstDigest ? "" : " MISMATCH");
+  }
+
+  std::vector<uint32_t> modesApplied, gestures, frames, dangerGaps;
+  uint32_t batteryChanges = 0;
+  uint64_t violations[kViolationKinds] = {};
+  uint32_t collarsViolating = 0;
+  for (const Result &r : results) {
+    modesApplied.push_back(r.modesApplied);
+    gestures.push_back(r.gestures);
+    frames.push_back(r.frames);
+    dangerGaps.push_back(r.maxDangerGapMs);
+    batteryChanges += r.batteryChanges;
+    bool any = false;
+    for (uint8_t k = 0; k < kViolationKinds; k++) {
+      violations[k] += r.violations[k];
+      any = any || r.violations[k] != 0;
+    }
+    collarsViolating += any;
+  }
+
+  std::printf("\nPer collar (p50 / max): gestures %u / %u, modes applied %u / %u, frames %u / %u\n",
+              percentile(gestures, 0.5), percentile(gestures, 1.0), percentile(modesApplied, 0.5),
+              percentile(modesApplied, 1.0), percentile(frames, 0.5), percentile(frames, 1.0));
+  std::printf("Battery tier changes: %u across the fleet\n", batteryChanges);
+  std::printf("Longest Danger frame gap: %ums (limit %ums)\n", percentile(dangerGaps, 1.0), kDangerGapMs);
+  std::printf("Invariant violations:");
+  for (uint8_t k = 0; k < kViolationKinds; k++) {
+    std::printf(" %s %llu%s", kViolationNames[k], (unsigned long long)violations[k], k + 1 < kViolationKinds ? "," : "");
+  }
+  std::printf(" (%u collars)\n", collarsViolating);
+  if (!digestsMatch) {
+    std::printf("Digest differs between thread counts: collars are not independent\n");
+  }
+  return (digestsMatch && collarsViolating == 0) ? 0 : 1;
+}
@@ -0,0 +1,244 @@
+// Host simulation: flight recorder across a power loss.
+//
+// Session 1 boots from power-on, walks through modes from the remote and the
+// serial port, and then loses power mid-way through Danger (a "went dark"
+// report). Session 2 boots from a brown-out with the same EEPROM, and the
+// host sends 'f'. The dump should show session 1's events up to its last
+// checkpoint, followed by session 2's boot.
+//
+// It also reports EEPROM wear. A separate session on top of session 1's
+// EEPROM changes mode from the remote every kWearPressUs for kWearSeconds.
+// Its byte writes per cell are extrapolated to how long the busiest cell
+// lasts at 100k writes.
+//
+// Usage: sim_flight [session1_seconds]
+
+#include <Arduino.h>
+
+#include "config.h"
+#include "host_runtime.h"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr uint64_t kLoopPassUs = 8; // modeled cost of one loop() pass
+constexpr uint64_t kPressUs = 80000;
+constexpr uint64_t kDumpDrainUs = 4000000;
+constexpr uint32_t kCellEndurance = 100000;
+constexpr uint64_t kWearSeconds = 1800;
+constexpr uint64_t kWearPressUs = 10000000;
+
+struct Step {
+  uint64_t atUs;
+  int8_t remotePin; // -1 = serial byte
+  char serial;
+};
+
+struct Session {
+  std::string tx;
+  uint8_t eeprom[Host::kEepromBytes];
+  uint32_t writes[Host::kEepromBytes];
+};
+
+void onTx(uint8_t b, void *user) { static_cast<std::string *>(user)->push_back((char)b); }
+
+void press(uint8_t pin, uint64_t atUs, std::vector<Step> &script) {
+  script.push_back(Step{atUs, (int8_t)pin, 0});
+}
+
+void runFor(uint64_t untilUs, const std::vector<Step> &script, size_t &next) {
+  while (Host::nowUs() < untilUs) {
+    while (next < script.size() && script[next].atUs <= Host::nowUs()) {
+      const Step &s = script[next++];
+      if (s.remotePin >= 0) {
+        Host::setPinLevel((uint8_t)s.remotePin, false);
+      } else {
+        Host::pushSerialRx((uint8_t)s.serial, Host::nowUs());
+      }
+    }
+    // Remote presses are held for kPressUs. Only steps already started can
+    // be due, newest first.
+    for (size_t i = next; i-- > 0 && Host::nowUs() < script[i].atUs + kPressUs + 1000;) {
+      const Step &s = script[i];
+      if (s.remotePin >= 0 && Host::nowUs() >= s.atUs + kPressUs) {
+        Host::setPinLevel((uint8_t)s.remotePin, true);
+      }
+    }
+    loop();
+    Host::advanceUs(kLoopPassUs);
+  }
+}
+
+void runSession(uint64_t seconds, uint8_t resetFlags, std::vector<Step> script, bool dump, Session &out) {
+  out.tx.clear();
+  Host::setSerialTxSink(onTx, &out.tx);
+  MCUSR = resetFlags;
+
+  std::sort(script.begin(), script.end(), [](const Step &a, const Step &b) { return a.atUs < b.atUs; });
+  size_t next = 0;
+  setup();
+  runFor(seconds * 1000000ull, script, next);
+  if (dump) {
+    out.tx.clear();
+    Host::pushSerialRx('f', Host::nowUs());
+    Host::pushSerialRx('t', Host::nowUs() + kDumpDrainUs / 2);
+    runFor(Host::nowUs() + kDumpDrainUs, script, next);
+  }
+  std::copy(Host::eeprom(), Host::eeprom() + Host::kEepromBytes, out.eeprom);
+  for (uint16_t i = 0; i < Host::kEepromBytes; i++) {
+    out.writes[i] = Host::eepromWriteCount(i);
+  }
+}
+
+bool readAll(int fd, void *buf, size_t len) {
+  uint8_t *p = static_cast<uint8_t *>(buf);
+  while (len != 0) {
+    const ssize_t n = ::read(fd, p, len);
+    if (n <= 0) {
+      return false;
+    }
+    p += n;
+    len -= (size_t)n;
+  }
+  return true;
+}
+
+bool writeAll(int fd, const void *buf, size_t len) {
+  const uint8_t *p = static_cast<const uint8_t *>(buf);
+  while (len != 0) {
+    const ssize_t n = ::write(fd, p, len);
+    if (n <= 0) {
+      return false;
+    }
+    p += n;
+    len -= (size_t)n;
+  }
+  return true;
+}
+
+// The firmware keeps its state in statics, so each power cycle runs in a
+// fresh child process; only the EEPROM image carries over.
+Session simulate(const uint8_t *eepromIn, uint64_t seconds, uint8_t resetFlags, const std::vector<Step> &script,
+                 bool dump) {
+  int fds[2];
+  if (pipe(fds) != 0) {
+    std::perror("pipe");
+    std::exit(1);
+  }
+
+  const pid_t pid = fork();
+  if (pid < 0) {
+    std::perror("fork");
+    std::exit(1);
+  }
+  if (pid == 0) {
+    close(fds[0]);
+    if (eepromIn) {
+      std::copy(eepromIn, eepromIn + Host::kEepromBytes, Host::eeprom());
+    }
+    Session s;
+    runSession(seconds, resetFlags, script, dump, s);
+    const uint64_t txLen = s.tx.size();
+    const bool ok = writeAll(fds[1], &txLen, sizeof(txLen)) && writeAll(fds[1], s.tx.data(), s.tx.size()) &&
+                    writeAll(fds[1], s.eeprom, sizeof(s.eeprom)) && writeAll(fds[1], s.writes, sizeof(s.writes));
+    _exit(ok ? 0 : 1);
+  }
+
+  close(fds[1]);
+  Session s;
+  uint64_t txLen = 0;
+  bool ok = readAll(fds[0], &txLen, sizeof(txLen));
+  if (ok) {
+    s.tx.resize(txLen);
+    ok = readAll(fds[0], &s.tx[0], s.tx.size()) && readAll(fds[0], s.eeprom, sizeof(s.eeprom)) &&
+         readAll(fds[0], s.writes, sizeof(s.writes));
+  }
+  close(fds[0]);
+
+  int status = 0;
+  waitpid(pid, &status, 0);
+  if (!ok || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    std::fprintf(stderr, "simulation child failed\n");
+    std::exit(1);
+  }
+  return s;
+}
+
+void printLines(const std::string &tx, const char *needle) {
+  size_t pos = 0;
+  while (pos < tx.size()) {
+    size_t end = tx.find('\n', pos);
+    if (end == std::string::npos) {
+      end = tx.size();
+    }
+    const std::string line = tx.substr(pos, end - pos);
+    if (line.find(needle) != std::string::npos) {
+      std::printf("  %s\n", line.substr(0, line.find_last_not_of('\r') + 1).c_str());
+    }
+    pos = end + 1;
+  }
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  const uint64_t seconds = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 120;
+  if (seconds < 60) {
+    std::fprintf(stderr, "usage: %s [session1_seconds >= 60]\n", argv[0]);
+    return 2;
+  }
+
+  // Session 1: Idle -> Peace -> Warning (remote), Peace (serial), Danger
+  // (remote), then the power goes.
+  std::vector<Step> script;
+  press(Config::RemotePin3, 2000000, script);
+  press(Config::RemotePin3, seconds * 200000, script);
+  script.push_back(Step{seconds * 400000, -1, '2'});
+  press(Config::RemotePin3, seconds * 600000, script);
+  press(Config::RemotePin3, seconds * 800000, script);
+  const Session first = simulate(nullptr, seconds, 1u << PORF, script, false);
+  uint64_t totalWrites = 0;
+  for (uint16_t i = 0; i < Host::kEepromBytes; i++) {
+    totalWrites += first.writes[i];
+  }
+
+  // Session 2: brown-out reset, dump the recorder.
+  const Session second = simulate(first.eeprom, 2, 1u << BORF, {}, true);
+
+  // Wear: up (remote 3) and down again (remote 4, on release), non-stop.
+  std::vector<Step> wearScript;
+  for (uint64_t at = kWearPressUs; at < kWearSeconds * 1000000ull; at += kWearPressUs) {
+    press((at / kWearPressUs) % 2 ? Config::RemotePin3 : Config::RemotePin4, at, wearScript);
+  }
+  const Session wear = simulate(first.eeprom, kWearSeconds, 1u << PORF, wearScript, false);
+  uint64_t wearWrites = 0;
+  uint32_t maxWrites = 0;
+  for (uint16_t i = 0; i < Host::kEepromBytes; i++) {
+    wearWrites += wear.writes[i];
+    maxWrites = std::max(maxWrites, wear.writes[i]);
+  }
+
+  std::printf("Session 1: %llus, EEPROM byte writes=%llu\n", (unsigned long long)seconds,
+              (unsigned long long)totalWrites);
+  std::printf("Wear: a mode change every %llus for %llus, EEPROM byte writes=%llu, busiest cell=%u",
+              (unsigned long long)(kWearPressUs / 1000000), (unsigned long long)kWearSeconds,
+              (unsigned long long)wearWrites, maxWrites);
+  if (maxWrites != 0) {
+    std::printf(" (-> %.0f days of this to %u writes)",
+                (double)kCellEndurance / maxWrites * (double)kWearSeconds / 86400.0, kCellEndurance);
+  }
+  std::printf("\nSession 2 (brown-out) 'f' dump:\n");
+  printLines(second.tx, "FLIGHT");
+  std::printf("Task stats (session 2):\n");
+  printLines(second.tx, "TASK flight");
+  printLines(second.tx, "TASK frame");
+  return 0;
+}
@@ -0,0 +1,382 @@
+// Host simulation: remote gesture detection latency.
+//
+// Drives one Collar (include/collar.h) with scripted remote edges and polls it
+// every 1ms like the input task. Edges fall between polls (at +0.3ms) as they
+// would on a real remote. Each case checks which gestures fire and the mode
+// they leave. It reports two delays: from the first press to the mode change,
+// and from the decisive moment to the mode change. The decisive moment is when
+// the gesture can first be told apart: the press for a tap-only button, the
+// release or the end of a window otherwise, the second press for a chord or
+// double press. The second is the engine's own overhead and must stay within
+// one poll.
+//
+// Then the panic chord (Config::remoteBindings()) is swept: the second button at
+// every 5ms across the chord window, both ways round, must switch to Danger
+// and show a Danger frame within kPanicBoundMs of its press. From the end of
+// the window on, it must not. Last, the same chord goes through the whole
+// firmware (setup()/loop(): input task, remote task, frame task), timed from
+// the second press to the first red-only frame, against kFirmwarePanicBoundUs.
+//
+// Usage: sim_gestures
+
+#include <Arduino.h>
+
+#include "collar.h"
+#include "config.h"
+#include "host_runtime.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+
+typedef Collar::Gestures::RemoteAction RemoteAction;
+typedef Collar::Gestures::RemoteBinding RemoteBinding;
+typedef Collar::Gestures::RemoteGesture RemoteGesture;
+
+constexpr uint32_t kStartMs = 1000;  // clear of the 0 = "not started" markers
+constexpr uint32_t kEdgePhaseUs = 300;
+constexpr uint64_t kLoopPassUs = 8;  // modeled cost of one loop() pass
+constexpr uint32_t kSettleMs = 1000; // run on after the last edge
+// Input poll plus the frame task after it, as in the firmware's task table.
+constexpr uint32_t kPanicBoundMs = Config::InputTaskPeriodMs + Config::FrameTaskPeriodMs;
+// Through the scheduler the poll can also find a frame task already running
+// (the budget of one frame) and the input and remote tasks run in turn.
+constexpr uint32_t kFirmwarePanicBoundUs = 1000u * kPanicBoundMs + Config::FrameTaskBudgetUs;
+
+const char *const kModeNames[] = {"?", "Idle", "Peace", "Warning", "Danger", "SolidGreen", "SolidYellow", "SolidRed"};
+const char *const kGestureNames[] = {"?", "tap", "double", "long", "chord"};
+const uint8_t kRemotePins[] = {Config::RemotePin1, Config::RemotePin2, Config::RemotePin3, Config::RemotePin4};
+
+constexpr uint8_t kSolidUp = Config::RemoteIndexSolidUp;
+constexpr uint8_t kSolidDown = Config::RemoteIndexSolidDown;
+constexpr uint8_t kAnimUp = Config::RemoteIndexAnimUp;
+constexpr uint8_t kAnimDown = Config::RemoteIndexAnimDown;
+
+struct Edge {
+  uint32_t atMs; // from the start of the case; lands at +kEdgePhaseUs
+  uint8_t button;
+  bool down;
+};
+
+struct Case {
+  const char *name;
+  LedMode start;
+  bool withDouble; // add a double press on "animated up" -> Danger
+  std::vector<Edge> edges;
+  uint32_t decisiveMs; // from the start of the case
+  std::string expectFired;
+  LedMode expectMode;
+};
+
+struct Outcome {
+  std::string fired;
+  LedMode mode = LedMode::Idle;
+  double modeUs = -1;  // first mode change, case time
+  double frameUs = -1; // first frame after it, case time
+};
+
+struct Run {
+  bool changed = false;
+  uint64_t changedUs = 0;
+  uint64_t frameUs = 0;
+  bool framed = false;
+};
+
+void onFrame(uint64_t atUs, const uint8_t *rgb, uint16_t count, void *user) {
+  (void)rgb;
+  (void)count;
+  Run &run = *static_cast<Run *>(user);
+  if (run.changed && !run.framed) {
+    run.framed = true;
+    run.frameUs = std::max(atUs, run.changedUs);
+  }
+}
+
+void onModeChange(LedMode mode, Flight::Source source, void *user) {
+  (void)mode;
+  (void)source;
+  Run &run = *static_cast<Run *>(user);
+  if (!run.changed) {
+    run.changed = true;
+    run.changedUs = Host::nowUs();
+  }
+}
+
+std::vector<RemoteBinding> bindingsFor(bool withDouble) {
+  uint8_t count;
+  const RemoteBinding *defaults = Config::remoteBindings(count);
+  std::vector<RemoteBinding> table(defaults, defaults + count);
+  if (withDouble) {
+    table.push_back({RemoteGesture::Double, (uint8_t)(1u << kAnimUp), RemoteAction::Danger});
+  }
+  return table;
+}
+
+std::string describe(const Collar::Gestures::Fired &g) {
+  std::string s = kGestureNames[static_cast<uint8_t>(g.gesture) < 5 ? static_cast<uint8_t>(g.gesture) : 0];
+  char sep = ' ';
+  for (uint8_t i = 0; i < Collar::kRemoteCount; i++) {
+    if (g.buttons & (1u << i)) {
+      s += sep;
+      s += (char)('1' + i);
+      sep = '+';
+    }
+  }
+  return s;
+}
+
+Outcome runCase(const Case &c) {
+  Host::reset();
+  Run run;
+  PixelStrip strip;
+  Collar collar(strip, onModeChange, &run);
+  const std::vector<RemoteBinding> table = bindingsFor(c.withDouble);
+  collar.gestures().setBindings(table.data(), (uint8_t)table.size());
+
+  Host::setFrameHook(onFrame, &run);
+  Host::advanceUs((uint64_t)kStartMs * 1000);
+  collar.ring().begin();
+  collar.ring().setCrossfadeEnabled(false);
+  collar.ring().setMode(c.start, true);
+  collar.ring().setCrossfadeEnabled(true);
+
+  bool high[Collar::kRemoteCount];
+  std::fill(high, high + Collar::kRemoteCount, true);
+  collar.beginRemotes(high);
+
+  const uint64_t baseUs = (uint64_t)kStartMs * 1000;
+  uint32_t lastEdgeMs = 0;
+  for (const Edge &e : c.edges) {
+    lastEdgeMs = std::max(lastEdgeMs, e.atMs);
+  }
+
+  Outcome out;
+  size_t next = 0;
+  for (uint32_t ms = 1; ms <= lastEdgeMs + kSettleMs; ms++) {
+    const uint64_t nowUs = baseUs + (uint64_t)ms * 1000;
+    if (Host::nowUs() < nowUs) {
+      Host::advanceUs(nowUs - Host::nowUs());
+    }
+    for (; next < c.edges.size() && (uint64_t)c.edges[next].atMs * 1000 + kEdgePhaseUs <= (uint64_t)ms * 1000;
+         next++) {
+      high[c.edges[next].button] = !c.edges[next].down;
+    }
+
+    const uint32_t nowMs = kStartMs + ms;
+    collar.pollRemotes(high, nowMs);
+    Collar::Gestures::Fired g;
+    while (collar.takeGesture(g)) {
+      out.fired += (out.fired.empty() ? "" : ", ") + describe(g);
+      collar.handleGesture(g, nowMs);
+    }
+    collar.update(nowMs, nowMs);
+  }
+
+  Host::setFrameHook(nullptr, nullptr);
+  out.mode = collar.ring().mode();
+  if (run.changed) {
+    out.modeUs = (double)(run.changedUs - baseUs);
+  }
+  if (run.framed) {
+    out.frameUs = (double)(run.frameUs - baseUs);
+  }
+  return out;
+}
+
+// ---- whole firmware ----
+
+struct FirmwareRun {
+  bool armed = false;
+  bool seen = false;
+  uint64_t dangerUs = 0;
+};
+
+// The first Danger frames (chase, pulse) are red only; Peace never is.
+void onFirmwareFrame(uint64_t atUs, const uint8_t *rgb, uint16_t count, void *user) {
+  FirmwareRun &run = *static_cast<FirmwareRun *>(user);
+  if (!run.armed || run.seen) {
+    return;
+  }
+  bool red = false, other = false;
+  for (uint16_t i = 0; i < count; i++) {
+    red = red || rgb[i * 3] != 0;
+    other = other || rgb[i * 3 + 1] != 0 || rgb[i * 3 + 2] != 0;
+  }
+  if (red && !other) {
+    run.seen = true;
+    run.dangerUs = atUs;
+  }
+}
+
+void runFirmwareUntil(uint64_t untilUs) {
+  while (Host::nowUs() < untilUs) {
+    loop();
+    Host::advanceUs(kLoopPassUs);
+  }
+}
+
+// Worst second-press-to-Danger-frame over the sweep; -1 if one never came.
+double firmwarePanicUs(uint8_t first, uint8_t second, uint32_t chordMs, uint32_t &runs) {
+  Host::reset();
+  FirmwareRun run;
+  Host::setFrameHook(onFirmwareFrame, &run);
+  setup();
+  double worst = 0;
+  for (uint32_t off = 0; off < chordMs; off += 10) {
+    Host::pushSerialRx('2', Host::nowUs());
+    runFirmwareUntil(Host::nowUs() + 600000);
+    const uint64_t t0 = Host::nowUs() + kEdgePhaseUs;
+    runFirmwareUntil(t0);
+    Host::setPinLevel(kRemotePins[first], false);
+    runFirmwareUntil(t0 + (uint64_t)off * 1000);
+    Host::setPinLevel(kRemotePins[second], false);
+    const uint64_t secondUs = Host::nowUs();
+    run.armed = true;
+    run.seen = false;
+    runFirmwareUntil(secondUs + 300000);
+    run.armed = false;
+    Host::setPinLevel(kRemotePins[first], true);
+    Host::setPinLevel(kRemotePins[second], true);
+    runFirmwareUntil(Host::nowUs() + 300000);
+    runs++;
+    if (!run.seen) {
+      worst = -1;
+      break;
+    }
+    worst = std::max(worst, (double)(run.dangerUs - secondUs));
+  }
+  Host::setFrameHook(nullptr, nullptr);
+  return worst;
+}
+
+std::vector<Edge> tap(uint8_t button, uint32_t atMs, uint32_t holdMs) {
+  return {{atMs, button, true}, {atMs + holdMs, button, false}};
+}
+
+std::vector<Edge> operator+(std::vector<Edge> a, const std::vector<Edge> &b) {
+  a.insert(a.end(), b.begin(), b.end());
+  std::sort(a.begin(), a.end(), [](const Edge &x, const Edge &y) { return x.atMs < y.atMs; });
+  return a;
+}
+
+std::string fmtMs(double us) {
+  char buf[32];
+  if (us < 0) {
+    return "-";
+  }
+  std::snprintf(buf, sizeof(buf), "%.1fms", us / 1000.0);
+  return buf;
+}
+
+} // namespace
+
+int main() {
+  const uint32_t chord = Config::RemoteChordWindowMs;
+  const uint32_t longMs = Config::RemoteLongPressMs;
+  const uint32_t gap = Config::RemoteDoubleGapMs;
+
+  const std::vector<Case> cases = {
+      {"tap, tap-only button", LedMode::SolidRed, false, tap(kSolidDown, 0, 100), 0, "tap 2", LedMode::SolidYellow},
+      {"tap, chord member, quick", LedMode::Idle, false, tap(kAnimUp, 0, 50), 50, "tap 3", LedMode::Peace},
+      {"tap, chord member, held", LedMode::Idle, false, tap(kAnimUp, 0, 300), chord, "tap 3", LedMode::Peace},
+      {"tap, long bound", LedMode::Warning, false, tap(kAnimDown, 0, 150), 150, "tap 4", LedMode::Peace},
+      {"long press", LedMode::Danger, false, tap(kAnimDown, 0, longMs + 300), longMs, "long 4", LedMode::Idle},
+      {"chord, together", LedMode::Peace, false, tap(kSolidUp, 0, 200) + tap(kAnimUp, 0, 200), 0, "chord 1+3",
+       LedMode::Danger},
+      {"chord, 2nd late in window", LedMode::Peace, false, tap(kAnimUp, 0, 300) + tap(kSolidUp, chord - 10, 200),
+       chord - 10, "chord 1+3", LedMode::Danger},
+      {"chord, 2nd past window", LedMode::Idle, false, tap(kAnimUp, 0, 300) + tap(kSolidUp, chord + 20, 40), chord,
+       "tap 3, tap 1", LedMode::SolidGreen},
+      {"double bound, single tap", LedMode::Idle, true, tap(kAnimUp, 0, 60), 60 + gap, "tap 3", LedMode::Peace},
+      {"double press", LedMode::Idle, true, tap(kAnimUp, 0, 60) + tap(kAnimUp, 150, 60), 150, "double 3",
+       LedMode::Danger},
+      {"double, 2nd past gap", LedMode::Idle, true, tap(kAnimUp, 0, 60) + tap(kAnimUp, 60 + gap + 20, 60), 60 + gap,
+       "tap 3, tap 3", LedMode::Warning},
+      {"bounce on press, tap-only", LedMode::SolidRed, false,
+       tap(kSolidDown, 0, 1) + tap(kSolidDown, 2, 1) + tap(kSolidDown, 4, 100), 0, "tap 2", LedMode::SolidYellow},
+      {"bounce on release", LedMode::Warning, false,
+       tap(kAnimDown, 0, 150) + tap(kAnimDown, 152, 1) + tap(kAnimDown, 154, 1), 150, "tap 4", LedMode::Peace},
+  };
+
+  std::printf("Gesture latency (1ms input poll, edges at +0.%ums; LongPressMs %u, DoubleGapMs %u, "
+              "ChordWindowMs %u, DebounceMs %u)\n\n",
+              kEdgePhaseUs / 100, longMs, gap, chord, Config::RemoteDebounceMs);
+  std::printf("%-28s %-20s %-12s %10s %10s\n", "case", "fired", "mode", "from press", "after edge");
+  uint32_t failures = 0;
+  for (const Case &c : cases) {
+    const Outcome o = runCase(c);
+    const double firstPressUs = (double)c.edges.front().atMs * 1000 + kEdgePhaseUs;
+    // Windows run from an edge, so the decisive moment carries its phase too.
+    const double decisiveUs = (double)c.decisiveMs * 1000 + kEdgePhaseUs;
+    const bool ok = o.fired == c.expectFired && o.mode == c.expectMode && o.modeUs >= 0 &&
+                    o.modeUs - decisiveUs <= 1000.0 * Config::InputTaskPeriodMs;
+    failures += ok ? 0 : 1;
+    std::printf("%-28s %-20s %-12s %10s %10s  %s\n", c.name, o.fired.c_str(),
+                kModeNames[static_cast<uint8_t>(o.mode)], fmtMs(o.modeUs - firstPressUs).c_str(),
+                fmtMs(o.modeUs - decisiveUs).c_str(), ok ? "ok" : ("FAIL, expected " + c.expectFired).c_str());
+  }
+
+  // Panic chord sweep.
+  uint8_t panic = 0;
+  uint8_t bindingCount;
+  const RemoteBinding *bindings = Config::remoteBindings(bindingCount);
+  for (uint8_t i = 0; i < bindingCount; i++) {
+    if (bindings[i].gesture == RemoteGesture::Chord && bindings[i].action == RemoteAction::Danger) {
+      panic = bindings[i].buttons;
+    }
+  }
+  if (panic == 0) {
+    std::printf("\nNo chord bound to Danger in Config::remoteBindings()\n");
+    return failures ? 1 : 0;
+  }
+  uint8_t a = 0;
+  while (!(panic & (1u << a))) {
+    a++;
+  }
+  uint8_t b = (uint8_t)(a + 1);
+  while (!(panic & (1u << b))) {
+    b++;
+  }
+
+  double worstModeUs = 0, worstFrameUs = 0;
+  uint32_t sweeps = 0, misses = 0, falseFires = 0;
+  for (uint8_t order = 0; order < 2; order++) {
+    const uint8_t first = order ? b : a;
+    const uint8_t second = order ? a : b;
+    for (uint32_t off = 0; off <= chord + 40; off += 5) {
+      const Case c{"panic", LedMode::Peace, false, tap(first, 0, 400) + tap(second, off, 400), off, "", LedMode::Danger};
+      const Outcome o = runCase(c);
+      const double secondUs = (double)off * 1000 + kEdgePhaseUs;
+      if (off >= chord) {
+        falseFires += (o.fired.find("chord") != std::string::npos) ? 1 : 0;
+        continue;
+      }
+      sweeps++;
+      if (o.fired.rfind("chord", 0) != 0 || o.modeUs < 0 || o.frameUs < 0) {
+        misses++;
+        continue;
+      }
+      worstModeUs = std::max(worstModeUs, o.modeUs - secondUs);
+      worstFrameUs = std::max(worstFrameUs, o.frameUs - secondUs);
+    }
+  }
+  const bool panicOk = misses == 0 && falseFires == 0 && worstFrameUs <= 1000.0 * kPanicBoundMs;
+  std::printf("\nPanic chord %u+%u -> Danger, 2nd press 0-%ums after the 1st, both orders (%u runs):\n", a + 1,
+              b + 1, chord - 5, sweeps);
+  std::printf("  after the 2nd press: mode %s, first Danger frame %s (bound %ums)\n", fmtMs(worstModeUs).c_str(),
+              fmtMs(worstFrameUs).c_str(), kPanicBoundMs);
+  std::printf("  missed %u, fired past the window %u: %s\n", misses, falseFires, panicOk ? "ok" : "FAIL");
+
+  uint32_t firmwareRuns = 0;
+  const double fwAB = firmwarePanicUs(a, b, chord, firmwareRuns);
+  const double fwBA = firmwarePanicUs(b, a, chord, firmwareRuns);
+  const double fwWorst = (fwAB < 0 || fwBA < 0) ? -1 : std::max(fwAB, fwBA);
+  const bool firmwareOk = fwWorst >= 0 && fwWorst <= kFirmwarePanicBoundUs;
+  std::printf("  whole firmware (%u runs): first Danger frame %s after the 2nd press (bound %ums): %s\n",
+              firmwareRuns, fmtMs(fwWorst).c_str(), kFirmwarePanicBoundUs / 1000, firmwareOk ? "ok" : "FAIL");
+
+  return (failures == 0 && panicOk && firmwareOk) ? 0 : 1;
+}
@@ -0,0 +1,212 @@
+// Host simulation: frame jitter under a serial flood.
+//
+// Runs the firmware twice against a simulated clock in Danger mode (the
+// always-on mode with the shortest step interval): once with a quiet serial
+// line, once while the host floods it with help requests and garbage bytes
+// over a slow (9600 baud) port. Frame timing of the flooded run is compared
+// interval by interval against the quiet run, then the firmware's own task
+// stats ('t' command) are printed.
+//
+// Usage: sim_scheduler [seconds] [flood_byte_interval_us]
+
+#include <Arduino.h>
+
+#include "host_runtime.h"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr uint64_t kLoopPassUs = 8; // modeled cost of one loop() pass
+constexpr uint64_t kDangerAtUs = 500000;
+constexpr uint64_t kFloodStartUs = 2000000;
+constexpr uint64_t kStatsDrainUs = 2000000;
+
+struct Run {
+  std::vector<uint64_t> frameUs;
+  std::string tx;
+  uint64_t rxBytes = 0;
+};
+
+void onFrame(uint64_t atUs, const uint8_t *rgb, uint16_t count, void *user) {
+  (void)rgb;
+  (void)count;
+  static_cast<Run *>(user)->frameUs.push_back(atUs);
+}
+
+void onTx(uint8_t b, void *user) { static_cast<Run *>(user)->tx.push_back((char)b); }
+
+void runFor(uint64_t untilUs) {
+  while (Host::nowUs() < untilUs) {
+    loop();
+    Host::advanceUs(kLoopPassUs);
+  }
+}
+
+Run simulateInProcess(uint64_t seconds, uint64_t floodEveryUs) {
+  Run run;
+  Host::setFrameHook(onFrame, &run);
+  Host::setSerialTxSink(onTx, &run);
+
+  const uint64_t endUs = seconds * 1000000ull;
+  Host::pushSerialRx('4', kDangerAtUs);
+
+  if (floodEveryUs != 0) {
+    static const char kFlood[] = "hx?zq";
+    uint64_t i = 0;
+    for (uint64_t t = kFloodStartUs; t < endUs - kFloodStartUs; t += floodEveryUs, i++) {
+      Host::pushSerialRx((uint8_t)kFlood[i % (sizeof(kFlood) - 1)], t);
+      run.rxBytes++;
+    }
+  }
+
+  setup();
+  runFor(endUs);
+
+  // Let the flood drain, then ask for task stats.
+  const size_t statsFrom = run.tx.size();
+  Host::pushSerialRx('t', Host::nowUs());
+  runFor(Host::nowUs() + kStatsDrainUs);
+  run.frameUs.erase(std::remove_if(run.frameUs.begin(), run.frameUs.end(), [&](uint64_t t) { return t >= endUs; }),
+                    run.frameUs.end());
+  run.tx.erase(0, statsFrom);
+
+  return run;
+}
+
+bool readAll(int fd, void *buf, size_t len) {
+  uint8_t *p = static_cast<uint8_t *>(buf);
+  while (len != 0) {
+    const ssize_t n = ::read(fd, p, len);
+    if (n <= 0) {
+      return false;
+    }
+    p += n;
+    len -= (size_t)n;
+  }
+  return true;
+}
+
+bool writeAll(int fd, const void *buf, size_t len) {
+  const uint8_t *p = static_cast<const uint8_t *>(buf);
+  while (len != 0) {
+    const ssize_t n = ::write(fd, p, len);
+    if (n <= 0) {
+      return false;
+    }
+    p += n;
+    len -= (size_t)n;
+  }
+  return true;
+}
+
+// The firmware keeps its state in statics, so each scenario runs in a fresh
+// child process that boots from power-on and reports back over a pipe.
+Run simulate(uint64_t seconds, uint64_t floodEveryUs) {
+  int fds[2];
+  if (pipe(fds) != 0) {
+    std::perror("pipe");
+    std::exit(1);
+  }
+
+  const pid_t pid = fork();
+  if (pid < 0) {
+    std::perror("fork");
+    std::exit(1);
+  }
+  if (pid == 0) {
+    close(fds[0]);
+    const Run run = simulateInProcess(seconds, floodEveryUs);
+    const uint64_t header[3] = {run.frameUs.size(), run.tx.size(), run.rxBytes};
+    const bool ok = writeAll(fds[1], header, sizeof(header)) &&
+                    writeAll(fds[1], run.frameUs.data(), run.frameUs.size() * sizeof(uint64_t)) &&
+                    writeAll(fds[1], run.tx.data(), run.tx.size());
+    _exit(ok ? 0 : 1);
+  }
+
+  close(fds[1]);
+  Run run;
+  uint64_t header[3];
+  bool ok = readAll(fds[0], header, sizeof(header));
+  if (ok) {
+    run.frameUs.resize(header[0]);
+    run.tx.resize(header[1]);
+    run.rxBytes = header[2];
+    ok = readAll(fds[0], run.frameUs.data(), run.frameUs.size() * sizeof(uint64_t)) &&
+         readAll(fds[0], &run.tx[0], run.tx.size());
+  }
+  close(fds[0]);
+
+  int status = 0;
+  waitpid(pid, &status, 0);
+  if (!ok || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    std::fprintf(stderr, "simulation child failed\n");
+    std::exit(1);
+  }
+  return run;
+}
+
+uint64_t percentile(std::vector<uint64_t> v, double p) {
+  if (v.empty()) {
+    return 0;
+  }
+  std::sort(v.begin(), v.end());
+  const size_t idx = (size_t)(p * (double)(v.size() - 1) + 0.5);
+  return v[idx];
+}
+
+void printStats(const std::string &tx) {
+  size_t pos = 0;
+  while (pos < tx.size()) {
+    size_t end = tx.find('\n', pos);
+    if (end == std::string::npos) {
+      end = tx.size();
+    }
+    const std::string line = tx.substr(pos, end - pos);
+    if (line.find("TASK ") != std::string::npos || line.find("LOG:") != std::string::npos) {
+      std::printf("  %s\n", line.substr(0, line.find_last_not_of('\r') + 1).c_str());
+    }
+    pos = end + 1;
+  }
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  const uint64_t seconds = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 20;
+  const uint64_t floodEveryUs = (argc > 2) ? std::strtoull(argv[2], nullptr, 10) : 500;
+  if (seconds * 1000000ull <= 2 * kFloodStartUs || floodEveryUs == 0) {
+    std::fprintf(stderr, "usage: %s [seconds > 4] [flood_byte_interval_us > 0]\n", argv[0]);
+    return 2;
+  }
+
+  const Run quiet = simulate(seconds, 0);
+  const Run flood = simulate(seconds, floodEveryUs);
+
+  // Per-frame jitter: how much each frame interval in the flooded run differs
+  // from the same interval in the quiet run.
+  const size_t frames = std::min(quiet.frameUs.size(), flood.frameUs.size());
+  std::vector<uint64_t> jitterUs;
+  for (size_t i = 1; i < frames; i++) {
+    const int64_t q = (int64_t)(quiet.frameUs[i] - quiet.frameUs[i - 1]);
+    const int64_t f = (int64_t)(flood.frameUs[i] - flood.frameUs[i - 1]);
+    jitterUs.push_back((uint64_t)std::llabs(f - q));
+  }
+
+  std::printf("Simulated %llus in Danger mode, serial flood: 1 byte / %lluus (%llu bytes)\n",
+              (unsigned long long)seconds, (unsigned long long)floodEveryUs, (unsigned long long)flood.rxBytes);
+  std::printf("Frames: quiet=%zu flood=%zu\n", quiet.frameUs.size(), flood.frameUs.size());
+  std::printf("Frame interval jitter vs quiet run: p50=%lluus p99=%lluus max=%lluus\n",
+              (unsigned long long)percentile(jitterUs, 0.50), (unsigned long long)percentile(jitterUs, 0.99),
+              (unsigned long long)percentile(jitterUs, 1.0));
+  std::printf("Task stats (flood run):\n");
+  printStats(flood.tx);
+  return 0;
+}
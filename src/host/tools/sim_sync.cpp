@@ -0,0 +1,327 @@
+// Host simulation: phase sync between a leader and several followers.
+//
+// Every collar gets its own LedRingController, a skewed millis() clock
+// (ceramic resonators are good to ~0.5%, so two collars can differ by up to
+// 1%; the skew printed per follower is against the leader) and a random
+// power-on time. The leader steps through modes on a script and broadcasts
+// beacons over a simulated Serial1 link (transit time from Config::SyncBaud,
+// random loss).
+//
+// Two follower groups run side by side on identical clocks:
+//   synced - Sync::Follower (clock slewing + state resync)
+//   free   - only copies the leader's mode when it changes, i.e. today's
+//            behavior with every handler pressing the same button at once
+//
+// Phase error = when a follower shows a given animation step minus when the
+// leader showed the same step. Reported per time window. Frames a follower
+// draws in its old mode while a mode-change beacon is still in flight are
+// counted separately as "stale", and Idle (blank) frames are skipped.
+//
+// Usage: sim_sync [followers] [seconds] [loss_percent]
+
+#include <Arduino.h>
+
+#include "host_runtime.h"
+#include "led_ring.h"
+#include "phase_sync.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <map>
+#include <memory>
+#include <random>
+#include <tuple>
+#include <vector>
+
+namespace {
+
+constexpr uint64_t kTickUs = 250;
+constexpr uint64_t kWindowUs = 20000000;
+constexpr uint64_t kLinkUs = (uint64_t)Sync::kFrameBytes * 10u * 1000000u / Config::SyncBaud;
+
+using FrameKey = std::tuple<uint8_t, uint8_t, uint8_t, uint8_t, uint16_t>;
+
+FrameKey keyOf(const AnimationSnapshot &s) {
+  return FrameKey(static_cast<uint8_t>(s.mode), s.powerState, s.activeCyclesDone, s.phase, s.step);
+}
+
+enum class Role : uint8_t { Leader, Synced, Free };
+
+struct Collar {
+  Role role;
+  double ppm;
+  uint64_t bootUs;
+  PixelStrip strip;
+  LedRingController ring;
+  Sync::Leader leader;
+  Sync::Follower follower;
+  Sync::BeaconParser parser;
+  uint32_t lastLocalMs = 0xFFFFFFFFu;
+  uint32_t animMs = 0;
+  bool haveKey = false;
+  FrameKey lastKey;
+
+  // Dithering resends frames between steps, which would look like steps here;
+  // phase error is about when steps are drawn, so leave it off.
+  Collar(Role r, double skewPpm, uint64_t boot)
+      : role(r), ppm(skewPpm), bootUs(boot), strip(), ring(strip) {
+    ring.setDitherEnabled(false);
+  }
+
+  bool booted(uint64_t trueUs) const { return trueUs >= bootUs; }
+
+  uint32_t localMs(uint64_t trueUs) const {
+    return (uint32_t)((double)(trueUs - bootUs) * (1.0 + ppm * 1e-6) / 1000.0);
+  }
+
+  uint32_t animNow(uint32_t local) {
+    return (role == Role::Leader) ? leader.animNow(local) : (role == Role::Synced) ? follower.animNow(local) : local;
+  }
+};
+
+struct Frame {
+  uint64_t trueUs;
+  FrameKey key;
+};
+
+struct InFlight {
+  uint64_t arriveUs;
+  uint8_t bytes[Sync::kFrameBytes];
+};
+
+struct Sim {
+  std::vector<std::unique_ptr<Collar>> collars;
+  std::vector<std::vector<Frame>> frames;
+  uint64_t trueUs = 0;
+  Collar *current = nullptr;
+  size_t currentIndex = 0;
+};
+
+Sim sim;
+
+void onFrame(uint64_t atUs, const uint8_t *rgb, uint16_t count, void *user) {
+  (void)atUs;
+  (void)rgb;
+  (void)count;
+  (void)user;
+  Collar &c = *sim.current;
+  const FrameKey key = keyOf(c.ring.snapshot(c.animMs));
+  if (c.haveKey && key == c.lastKey) {
+    return; // same step redrawn (fade ramp, etc.)
+  }
+  c.haveKey = true;
+  c.lastKey = key;
+  sim.frames[sim.currentIndex].push_back(Frame{sim.trueUs, key});
+}
+
+// Nearest leader frame with the same key.
+bool phaseErrorUs(const std::map<FrameKey, std::vector<uint64_t>> &leader, const Frame &f, int64_t &errUs) {
+  const auto it = leader.find(f.key);
+  if (it == leader.end()) {
+    return false;
+  }
+  const std::vector<uint64_t> &times = it->second;
+  const auto pos = std::lower_bound(times.begin(), times.end(), f.trueUs);
+  int64_t best = INT64_MAX;
+  if (pos != times.end()) {
+    best = (int64_t)f.trueUs - (int64_t)*pos;
+  }
+  if (pos != times.begin()) {
+    const int64_t before = (int64_t)f.trueUs - (int64_t)*(pos - 1);
+    if (std::llabs(before) < std::llabs(best)) {
+      best = before;
+    }
+  }
+  errUs = best;
+  return true;
+}
+
+struct WindowStats {
+  std::vector<int64_t> synced;
+  std::vector<int64_t> free;
+};
+
+int64_t maxAbs(const std::vector<int64_t> &v) {
+  int64_t m = 0;
+  for (int64_t x : v) {
+    m = std::max<int64_t>(m, std::llabs(x));
+  }
+  return m;
+}
+
+int64_t p99Abs(std::vector<int64_t> v) {
+  if (v.empty()) {
+    return 0;
+  }
+  for (int64_t &x : v) {
+    x = std::llabs(x);
+  }
+  std::sort(v.begin(), v.end());
+  return v[(size_t)(0.99 * (double)(v.size() - 1))];
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  const int followers = (argc > 1) ? std::atoi(argv[1]) : 4;
+  const uint64_t seconds = (argc > 2) ? std::strtoull(argv[2], nullptr, 10) : 160;
+  const double lossPct = (argc > 3) ? std::atof(argv[3]) : 2.0;
+  if (followers < 1 || seconds < 20) {
+    std::fprintf(stderr, "usage: %s [followers >= 1] [seconds >= 20] [loss_percent]\n", argv[0]);
+    return 2;
+  }
+
+  std::mt19937 rng(12345);
+  std::uniform_real_distribution<double> skew(-5000.0, 5000.0);
+  std::uniform_int_distribution<uint64_t> boot(0, 3000000);
+  std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+  sim.collars.emplace_back(new Collar(Role::Leader, skew(rng), boot(rng)));
+  for (int i = 0; i < followers; i++) {
+    const double ppm = skew(rng);
+    const uint64_t bootUs = boot(rng);
+    sim.collars.emplace_back(new Collar(Role::Synced, ppm, bootUs));
+    sim.collars.emplace_back(new Collar(Role::Free, ppm, bootUs));
+  }
+  sim.frames.resize(sim.collars.size());
+  Host::setFrameHook(onFrame, nullptr);
+
+  // Leader's mode script (true time).
+  const std::vector<std::pair<uint64_t, LedMode>> script = {
+      {5000000, LedMode::Danger},
+      {(seconds / 4) * 1000000, LedMode::Peace},
+      {(seconds / 2) * 1000000, LedMode::Warning},
+      {(3 * seconds / 4) * 1000000, LedMode::Danger},
+  };
+  size_t nextScript = 0;
+
+  std::deque<InFlight> link;
+  uint64_t sent = 0;
+  uint64_t lost = 0;
+  const uint64_t endUs = seconds * 1000000;
+  std::vector<std::pair<uint64_t, LedMode>> leaderModes = {{0, LedMode::Idle}};
+
+  for (sim.trueUs = 0; sim.trueUs < endUs; sim.trueUs += kTickUs) {
+    Collar &leader = *sim.collars[0];
+
+    if (nextScript < script.size() && sim.trueUs >= script[nextScript].first && leader.booted(sim.trueUs)) {
+      leader.ring.setMode(script[nextScript].second);
+      leaderModes.emplace_back(sim.trueUs, script[nextScript].second);
+      nextScript++;
+    }
+
+    // Deliver beacons whose last byte has arrived.
+    while (!link.empty() && link.front().arriveUs <= sim.trueUs) {
+      const InFlight frame = link.front();
+      link.pop_front();
+      for (size_t i = 1; i < sim.collars.size(); i++) {
+        Collar &c = *sim.collars[i];
+        if (!c.booted(sim.trueUs) || unit(rng) * 100.0 < lossPct) {
+          lost++;
+          continue;
+        }
+        sim.current = &c;
+        sim.currentIndex = i;
+        Sync::Beacon b{};
+        bool decoded = false;
+        for (uint8_t byte : frame.bytes) {
+          decoded = c.parser.push(byte, b);
+        }
+        if (!decoded) {
+          continue;
+        }
+        if (c.role == Role::Synced) {
+          c.follower.onBeacon(b, c.localMs(sim.trueUs), c.ring);
+        } else if (c.ring.mode() != b.snap.mode) {
+          c.ring.setMode(b.snap.mode);
+        }
+      }
+    }
+
+    // Each collar's frame task: once per local millisecond.
+    for (size_t i = 0; i < sim.collars.size(); i++) {
+      Collar &c = *sim.collars[i];
+      if (!c.booted(sim.trueUs)) {
+        continue;
+      }
+      const uint32_t local = c.localMs(sim.trueUs);
+      if (local == c.lastLocalMs) {
+        continue;
+      }
+      c.lastLocalMs = local;
+      c.animMs = c.animNow(local);
+      sim.current = &c;
+      sim.currentIndex = i;
+      c.ring.update(c.animMs);
+
+      if (c.role == Role::Leader && c.leader.due(local, c.ring.mode())) {
+        InFlight frame;
+        frame.arriveUs = sim.trueUs + kLinkUs;
+        Sync::encode(c.leader.makeBeacon(local, c.ring), frame.bytes);
+        link.push_back(frame);
+        sent++;
+      }
+    }
+  }
+
+  std::map<FrameKey, std::vector<uint64_t>> leaderFrames;
+  for (const Frame &f : sim.frames[0]) {
+    leaderFrames[f.key].push_back(f.trueUs);
+  }
+
+  auto leaderModeAt = [&](uint64_t t) {
+    LedMode m = LedMode::Idle;
+    for (const auto &change : leaderModes) {
+      if (change.first <= t) {
+        m = change.second;
+      }
+    }
+    return m;
+  };
+
+  std::vector<WindowStats> windows((size_t)((endUs + kWindowUs - 1) / kWindowUs));
+  uint64_t staleSynced = 0;
+  uint64_t staleFree = 0;
+  for (size_t i = 1; i < sim.collars.size(); i++) {
+    const bool synced = sim.collars[i]->role == Role::Synced;
+    for (const Frame &f : sim.frames[i]) {
+      const LedMode mode = static_cast<LedMode>(std::get<0>(f.key));
+      if (mode == LedMode::Idle) {
+        continue;
+      }
+      if (mode != leaderModeAt(f.trueUs)) {
+        (synced ? staleSynced : staleFree)++;
+        continue;
+      }
+      int64_t err = 0;
+      if (!phaseErrorUs(leaderFrames, f, err)) {
+        continue;
+      }
+      WindowStats &w = windows[(size_t)(f.trueUs / kWindowUs)];
+      (synced ? w.synced : w.free).push_back(err);
+    }
+  }
+
+  std::printf("Leader + %d followers, %llus, link %lluus/beacon, %.1f%% loss, beacons sent=%llu lost=%llu\n", followers,
+              (unsigned long long)seconds, (unsigned long long)kLinkUs, lossPct, (unsigned long long)sent,
+              (unsigned long long)lost);
+  for (size_t i = 1; i < sim.collars.size(); i += 2) {
+    const Collar &c = *sim.collars[i];
+    std::printf("  follower %zu: skew vs leader %+6.0fppm, trim %+6.0fppm, beacons=%u resyncs=%u\n", (i + 1) / 2,
+                c.ppm - sim.collars[0]->ppm, (double)c.follower.animationClock().rateTrimQ16() * 1e6 / 65536.0,
+                (unsigned)c.follower.beaconCount(), (unsigned)c.follower.resyncCount());
+  }
+  std::printf("Stale-mode frames (mode beacon in flight): synced=%llu free=%llu\n", (unsigned long long)staleSynced,
+              (unsigned long long)staleFree);
+  std::printf("\n%-12s %14s %14s %14s %14s\n", "window", "synced p99", "synced max", "free p99", "free max");
+  for (size_t w = 0; w < windows.size(); w++) {
+    char label[32];
+    std::snprintf(label, sizeof(label), "%3llus-%3llus", (unsigned long long)(w * kWindowUs / 1000000),
+                  (unsigned long long)(std::min(endUs, (w + 1) * kWindowUs) / 1000000));
+    std::printf("%-12s %12.1fms %12.1fms %12.1fms %12.1fms\n", label, p99Abs(windows[w].synced) / 1000.0,
+                maxAbs(windows[w].synced) / 1000.0, p99Abs(windows[w].free) / 1000.0, maxAbs(windows[w].free) / 1000.0);
+  }
+  return 0;
+}
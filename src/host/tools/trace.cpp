@@ -0,0 +1,174 @@
+// Host tool: inspect a frame trace (src/host/frame_trace.h).
+//
+//   trace FILE                      summary: frames, span, size against the
+//                                   render --dump format, open/seek/decode
+//                                   timing
+//   trace FILE --at MS [--count N]  the frame showing at MS and the N-1 after
+//                                   it, as R,G,B per LED
+//   trace FILE --to-dump OUT        convert to the render --dump format, for
+//                                   byte-for-byte comparison with an old dump
+//
+// Usage: trace FILE [--at MS] [--count N] [--to-dump OUT]
+
+#include "frame_trace.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr uint32_t kSeekSamples = 10000;
+
+volatile uint32_t sink; // keeps the timed loops from being optimized out
+
+double usSince(Clock::time_point start) {
+  return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+}
+
+void printFrame(const FrameTrace::Cursor &c, uint16_t pixels) {
+  std::printf("%10.3fms #%-8llu", c.atUs() / 1000.0, (unsigned long long)c.frame());
+  for (uint16_t i = 0; i < pixels; i++) {
+    std::printf(" %02x%02x%02x", c.rgb()[i * 3], c.rgb()[i * 3 + 1], c.rgb()[i * 3 + 2]);
+  }
+  std::printf("\n");
+}
+
+bool toDump(const FrameTrace::Reader &r, const char *path) {
+  FILE *f = std::fopen(path, "wb");
+  if (!f) {
+    std::perror(path);
+    return false;
+  }
+  const uint8_t header[8] = {'T', 'C', 'F', 'D', 1, (uint8_t)r.pixels(), 0, 0};
+  bool ok = r.pixels() <= 0xFF && std::fwrite(header, 1, sizeof(header), f) == sizeof(header);
+  const size_t frameBytes = (size_t)r.pixels() * 3;
+  uint64_t frames = 0;
+  for (FrameTrace::Cursor c = r.begin(); ok && c.valid(); c.next()) {
+    const uint32_t ms = (uint32_t)(c.atUs() / 1000);
+    const uint8_t t[4] = {(uint8_t)ms, (uint8_t)(ms >> 8), (uint8_t)(ms >> 16), (uint8_t)(ms >> 24)};
+    ok = std::fwrite(t, 1, sizeof(t), f) == sizeof(t) && std::fwrite(c.rgb(), 1, frameBytes, f) == frameBytes;
+    frames++;
+  }
+  ok = (std::fclose(f) == 0) && ok;
+  if (!ok) {
+    std::fprintf(stderr, "%s: write failed\n", path);
+    return false;
+  }
+  if (frames != r.frames()) {
+    std::fprintf(stderr, "Decoded %llu of %llu frames: the trace is corrupt\n", (unsigned long long)frames,
+                 (unsigned long long)r.frames());
+    return false;
+  }
+  return true;
+}
+
+// False if the trace does not decode to the end.
+bool summary(const char *path, const FrameTrace::Reader &r, double openUs) {
+  const uint64_t dumpBytes = 8 + r.frames() * (4 + (uint64_t)r.pixels() * 3);
+  std::printf("%s: %u pixels, %u frames/block, %s\n", path, r.pixels(), r.framesPerBlock(),
+              r.indexed() ? "indexed" : "no index (cut short), rebuilt from blocks");
+  std::printf("Frames %llu in %u blocks, %.3fs to %.3fs\n", (unsigned long long)r.frames(), r.blocks(),
+              r.firstUs() / 1e6, r.lastUs() / 1e6);
+  std::printf("Size %zu bytes, %.2f per frame; as a --dump %llu bytes (%.1fx)\n", r.bytes(),
+              r.frames() ? (double)r.bytes() / r.frames() : 0.0, (unsigned long long)dumpBytes,
+              r.bytes() ? (double)dumpBytes / r.bytes() : 0.0);
+
+  const Clock::time_point decodeStart = Clock::now();
+  uint64_t frames = 0;
+  uint32_t check = 0;
+  for (FrameTrace::Cursor c = r.begin(); c.valid(); c.next()) {
+    check += c.rgb()[0];
+    frames++;
+  }
+  const double decodeUs = usSince(decodeStart);
+
+  std::mt19937_64 rng(1);
+  const uint64_t span = r.lastUs() - r.firstUs() + 1;
+  const Clock::time_point seekStart = Clock::now();
+  for (uint32_t i = 0; i < kSeekSamples && r.frames() != 0; i++) {
+    const FrameTrace::Cursor c = r.seek(r.firstUs() + rng() % span);
+    check += c.valid() ? c.rgb()[0] : 0;
+  }
+  const double seekUs = usSince(seekStart);
+
+  std::printf("Open %.1fus, seek %.2fus (mean of %u), full decode %.1fms (%.0fM frames/s)\n", openUs,
+              seekUs / kSeekSamples, kSeekSamples, decodeUs / 1000.0, decodeUs > 0 ? frames / decodeUs : 0.0);
+  sink = check;
+  if (frames != r.frames()) {
+    std::printf("Decoded %llu of %llu frames: the trace is corrupt\n", (unsigned long long)frames,
+                (unsigned long long)r.frames());
+    return false;
+  }
+  return true;
+}
+
+int usage(const char *argv0) {
+  std::fprintf(stderr, "usage: %s FILE [--at MS] [--count N] [--to-dump OUT]\n", argv0);
+  return 2;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  if (argc < 2 || argv[1][0] == '-') {
+    return usage(argv[0]);
+  }
+  const char *path = argv[1];
+  bool at = false;
+  double atMs = 0;
+  uint32_t count = 1;
+  const char *dumpPath = nullptr;
+  for (int argi = 2; argi < argc; argi++) {
+    const bool hasValue = argi + 1 < argc;
+    if (std::strcmp(argv[argi], "--at") == 0 && hasValue) {
+      at = true;
+      atMs = std::atof(argv[++argi]);
+    } else if (std::strcmp(argv[argi], "--count") == 0 && hasValue) {
+      count = (uint32_t)std::strtoul(argv[++argi], nullptr, 10);
+    } else if (std::strcmp(argv[argi], "--to-dump") == 0 && hasValue) {
+      dumpPath = argv[++argi];
+    } else {
+      return usage(argv[0]);
+    }
+  }
+  if (atMs < 0 || count == 0) {
+    return usage(argv[0]);
+  }
+
+  FrameTrace::Reader r;
+  const Clock::time_point openStart = Clock::now();
+  if (!r.open(path)) {
+    std::fprintf(stderr, "%s: not a frame trace (v%u), or its index is damaged\n", path, FrameTrace::kVersion);
+    return 1;
+  }
+  const double openUs = usSince(openStart);
+
+  if (dumpPath) {
+    return toDump(r, dumpPath) ? 0 : 1;
+  }
+  if (at) {
+    FrameTrace::Cursor c = r.seek((uint64_t)(atMs * 1000.0));
+    if (!c.valid() && r.frames() != 0) {
+      std::fprintf(stderr, "%s: the frames up to %.3fms do not decode: the trace is corrupt\n", path, atMs);
+      return 1;
+    }
+    uint64_t nextFrame = r.frames();
+    for (uint32_t i = 0; i < count && c.valid(); i++, c.next()) {
+      printFrame(c, r.pixels());
+      nextFrame = c.frame() + 1;
+    }
+    // Stopped short of both --count and the last frame: a delta did not decode.
+    if (!c.valid() && nextFrame < r.frames()) {
+      std::fprintf(stderr, "%s: frame %llu does not decode: the trace is corrupt\n", path,
+                   (unsigned long long)nextFrame);
+      return 1;
+    }
+    return 0;
+  }
+  return summary(path, r, openUs) ? 0 : 1;
+}
@@ -0,0 +1,236 @@
+// Host tool: the collar variants side by side (include/config.h).
+//
+// The firmware builds one variant per PlatformIO env; here every variant's
+// BasicCollar is instantiated in one program, from the same templates, and
+// runs each mode for a simulated minute (update() every 1ms, as the frame task
+// does). Per variant it prints what the config changes and what a frame costs.
+// The cost columns are estimates, not measurements: they count show() alone,
+// from the driver's cycle budget, and none of the mode animation code.
+//   cycles est.   show() at 16 MHz: the output loop's 20 cycles per bit plus
+//                 ~21 cycles per byte to scale and dither, ~33 while a
+//                 crossfade blends (docs/WS2812_DRIVER.md); no latch wait,
+//                 as frames are at least 1ms apart, past Ws2812's kLatchUs
+//   us est.       the blending case in time, against FrameTaskBudgetUs
+//   busy est.     share of the CPU spent in show() in the busiest mode; the
+//                 frame rate it is scaled by is simulated
+//   LED mA        mean LED current per mode, from the frames actually shown
+//                 (host battery model: 20mA per channel at 255, 0.6mA idle)
+// Flash and RAM come from the firmware builds: CI runs `pio run -t size` per
+// env and passes the figures in with --size. Exits non-zero if a variant's
+// estimated show() does not fit the frame task's budget; an animation that
+// grows slower is not caught here: only the device measures that (the 't'
+// command's frame maxUs).
+//
+// Usage: variants [--seconds N] [--size NAME=FLASH,RAM]...
+
+#include <Arduino.h>
+
+#include "collar.h"
+#include "host_runtime.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t kCpuHz = 16000000;
+constexpr uint32_t kOutputCyclesPerBit = 20;
+constexpr uint32_t kScaleCyclesPerByte = 21;
+constexpr uint32_t kBlendCyclesPerByte = 12;
+
+struct ModeRun {
+  const char *name;
+  LedMode mode;
+};
+
+const ModeRun kModes[] = {
+    {"peace", LedMode::Peace},
+    {"warning", LedMode::Warning},
+    {"danger", LedMode::Danger},
+    {"green", LedMode::SolidGreen},
+};
+constexpr uint8_t kModeCount = sizeof(kModes) / sizeof(kModes[0]);
+
+struct Size {
+  std::string name;
+  std::string flash;
+  std::string ram;
+};
+
+struct Row {
+  const char *name;
+  uint16_t pixels;
+  uint8_t pin;
+  uint8_t brightness;
+  uint32_t cycles;
+  uint32_t blendCycles;
+  double framesPerS[kModeCount];
+  double ledMa[kModeCount];
+};
+
+// Time-weighted LED current: each frame's current holds until the next one.
+struct Meter {
+  Host::BatteryModel model;
+  uint32_t nowMs = 0;
+  uint32_t lastMs = 0;
+  double lastMa = 0.0;
+  double maMs = 0.0;
+  uint32_t frames = 0;
+
+  void settle(uint32_t ms) {
+    maMs += lastMa * (ms - lastMs);
+    lastMs = ms;
+  }
+};
+
+void onFrame(uint64_t, const uint8_t *rgb, uint16_t count, void *user) {
+  Meter &m = *static_cast<Meter *>(user);
+  uint32_t levels = 0;
+  for (uint16_t i = 0; i < count * 3u; i++) {
+    levels += rgb[i];
+  }
+  m.settle(m.nowMs);
+  m.lastMa = m.model.ledIdleMa * count + m.model.ledMaPerChannel * (double)levels / 255.0;
+  m.frames++;
+}
+
+template <class Cfg> Row measure(const char *name, uint32_t seconds) {
+  Row row;
+  row.name = name;
+  row.pixels = Cfg::PixelCount;
+  row.pin = Cfg::NeoPixelPin;
+  row.brightness = Cfg::StripBrightness;
+  row.cycles = Cfg::PixelCount * 3u * (8 * kOutputCyclesPerBit + kScaleCyclesPerByte);
+  row.blendCycles = row.cycles + Cfg::PixelCount * 3u * kBlendCyclesPerByte;
+
+  for (uint8_t k = 0; k < kModeCount; k++) {
+    Host::reset();
+    Meter meter;
+    PixelStripFor<Cfg> strip;
+    BasicCollar<Cfg> collar(strip);
+    typename BasicCollar<Cfg>::Ring &ring = collar.ring();
+    Host::setFrameHook(onFrame, &meter);
+    ring.begin();
+    ring.setCrossfadeEnabled(false);
+    meter.frames = 0;
+    collar.applyMode(kModes[k].mode, Flight::Source::Serial, 1);
+
+    const uint32_t endMs = seconds * 1000u;
+    for (uint32_t ms = 1; ms <= endMs; ms++) {
+      meter.nowMs = ms;
+      collar.update(ms, ms);
+    }
+    meter.settle(endMs);
+    row.framesPerS[k] = (double)meter.frames / seconds;
+    row.ledMa[k] = meter.maMs / endMs;
+  }
+  Host::setFrameHook(nullptr, nullptr);
+  return row;
+}
+
+const Size *findSize(const std::vector<Size> &sizes, const char *name) {
+  for (const Size &s : sizes) {
+    if (s.name == name) {
+      return &s;
+    }
+  }
+  return nullptr;
+}
+
+bool parseSize(const char *arg, Size &out) {
+  const char *eq = std::strchr(arg, '=');
+  const char *comma = eq ? std::strchr(eq, ',') : nullptr;
+  if (!eq || !comma || eq == arg) {
+    return false;
+  }
+  out.name.assign(arg, eq);
+  out.flash.assign(eq + 1, comma);
+  out.ram.assign(comma + 1);
+  return !out.flash.empty() && !out.ram.empty();
+}
+
+// Arduino name and port pin, e.g. "A9 (PB5)": different numbers can be the
+// same pin (9 is PB5 too).
+std::string pinName(uint8_t pin) {
+  char buf[16];
+  if (pin >= A0 && pin < A0 + 12) { // A0-A11 on the ATmega32U4
+    std::snprintf(buf, sizeof(buf), "A%u (P%c%u)", pin - A0, Ws2812Pins::portOf(pin), Ws2812Pins::bitOf(pin));
+  } else {
+    std::snprintf(buf, sizeof(buf), "%u (P%c%u)", pin, Ws2812Pins::portOf(pin), Ws2812Pins::bitOf(pin));
+  }
+  return buf;
+}
+
+int usage(const char *argv0) {
+  std::fprintf(stderr, "usage: %s [--seconds N] [--size NAME=FLASH,RAM]...\n", argv0);
+  return 2;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  uint32_t seconds = 60;
+  std::vector<Size> sizes;
+  for (int argi = 1; argi < argc; argi++) {
+    const bool hasValue = argi + 1 < argc;
+    Size size;
+    if (std::strcmp(argv[argi], "--seconds") == 0 && hasValue) {
+      seconds = (uint32_t)std::strtoul(argv[++argi], nullptr, 10);
+    } else if (std::strcmp(argv[argi], "--size") == 0 && hasValue && parseSize(argv[argi + 1], size)) {
+      sizes.push_back(size);
+      argi++;
+    } else {
+      return usage(argv[0]);
+    }
+  }
+  if (seconds == 0) {
+    return usage(argv[0]);
+  }
+
+  const Row rows[] = {
+      measure<Variant::ProMicro8>("ProMicro8", seconds),
+      measure<Variant::ProMicro12>("ProMicro12", seconds),
+      measure<Variant::ProMicro16>("ProMicro16", seconds),
+  };
+
+  std::printf("This build: %s. Each mode %us, update() every 1ms\n\n", TAMECOLLAR_VARIANT_NAME, seconds);
+  std::printf("Variant     Pixels Pin      Cap   Flash    RAM   Cycles est.   us est.   Busiest   Busy est.\n");
+  bool ok = true;
+  for (const Row &r : rows) {
+    uint8_t busiest = 0;
+    for (uint8_t k = 1; k < kModeCount; k++) {
+      busiest = (r.framesPerS[k] > r.framesPerS[busiest]) ? k : busiest;
+    }
+    const double us = r.blendCycles * 1e6 / kCpuHz;
+    const Size *size = findSize(sizes, r.name);
+    std::printf("%-11s %6u %-8s %3u %7s %6s %6u (%5u) %9.0f   %-7s %3.0f/s %6.1f%%\n", r.name, r.pixels, pinName(r.pin).c_str(),
+                r.brightness, size ? size->flash.c_str() : "-", size ? size->ram.c_str() : "-", r.cycles,
+                r.blendCycles, us, kModes[busiest].name, r.framesPerS[busiest],
+                100.0 * r.framesPerS[busiest] * r.cycles / kCpuHz);
+    ok = ok && us <= Config::FrameTaskBudgetUs;
+  }
+  std::printf("(show() alone, estimated from the driver's cycle counts; in brackets: while a\n"
+              " crossfade blends. The mode animations are not counted.)\n\n");
+
+  std::printf("Mean LED mA ");
+  for (const ModeRun &m : kModes) {
+    std::printf(" %8s", m.name);
+  }
+  std::printf("\n");
+  for (const Row &r : rows) {
+    std::printf("%-11s ", r.name);
+    for (uint8_t k = 0; k < kModeCount; k++) {
+      std::printf(" %8.1f", r.ledMa[k]);
+    }
+    std::printf("\n");
+  }
+
+  if (!ok) {
+    std::printf("\nFAIL: an estimated show() does not fit FrameTaskBudgetUs (%uus)\n", Config::FrameTaskBudgetUs);
+    return 1;
+  }
+  return 0;
+}
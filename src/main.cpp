@@ -1,120 +1,11 @@
 #include <Arduino.h>
-#include <Adafruit_NeoPixel.h>
 
-// ----------------------------
-// Config (tuning knobs)
-// ----------------------------
-namespace Config {
-
-// Serial
-static constexpr uint32_t SerialBaud = 9600;
-
-// Serial logging
-// Startup wait is useful on native-USB boards (like ATmega32U4) so the host can
-// open the port and not miss the banner. Set to 0 to avoid waiting.
-static constexpr uint16_t SerialStartupWaitMs = 300;
-
-// Optional heartbeat log interval. Set to 0 to disable.
-static constexpr uint32_t SerialHeartbeatMs = 0;
-
-// Remote control input pins
-static constexpr uint8_t RemotePin1 = 7;
-static constexpr uint8_t RemotePin2 = 6;
-static constexpr uint8_t RemotePin3 = 5;
-static constexpr uint8_t RemotePin4 = 4;
-static constexpr uint8_t RemotePinCount = 4;
-
-static constexpr uint8_t RemoteIndexSolidUp = 0;   // REMOTE_PIN_1
-static constexpr uint8_t RemoteIndexSolidDown = 1; // REMOTE_PIN_2
-static constexpr uint8_t RemoteIndexAnimUp = 2;    // REMOTE_PIN_3
-static constexpr uint8_t RemoteIndexAnimDown = 3;  // REMOTE_PIN_4
-
-// WS2812 / NeoPixel
-static constexpr uint8_t NeoPixelPin = A9;
-static constexpr uint16_t PixelCount = 8;
-static constexpr uint8_t StripBrightness = 30; // 0-255
-
-// Power-saving loop (all modes except Danger)
-static constexpr uint32_t SleepMs = 1000;
-static constexpr uint32_t FadeMs = 250;
-static constexpr uint8_t ActiveCycles = 2;
-// Optional per-mode overrides for how many "cycles" to run each time we wake.
-// (A cycle = one full animation pass that returns "cycle done").
-static constexpr uint8_t ActiveCyclesPeace = 2;
-static constexpr uint8_t ActiveCyclesWarning = 2;
-static constexpr uint8_t ActiveCyclesSolid = 1;
-
-// Solid color mode
-static constexpr uint16_t SolidHoldMs = 3000;
-
-// Peace mode
-static constexpr uint16_t PeaceChaseStepMs = 90;
-static constexpr uint16_t PeaceChaseSteps = 24;
-static constexpr uint16_t PeaceHoldMs = 600;
-static constexpr uint8_t PeaceBackgroundScale = 40; // 0-255 dim green base
-static constexpr uint8_t PeaceChaseWidth = 2;
-
-static constexpr uint16_t PeacePulseStepMs = 45;
-static constexpr uint16_t PeacePulseSteps = 60;
-static constexpr uint8_t PeacePulseMinScale = 30;  // 0-255
-static constexpr uint8_t PeacePulseMaxScale = 200; // 0-255
-
-static constexpr uint16_t PeaceSparkleStepMs = 70;
-static constexpr uint16_t PeaceSparkleSteps = 28;
-static constexpr uint8_t PeaceSparkleCount = 3;
-static constexpr uint8_t PeaceSparkleScale = 255; // 0-255
-static constexpr uint8_t PeaceSprinkleScale = 200; // 0-255 (brightness for blue/cyan/purple sprinkles)
-
-// Warning mode (yellow hazard + white strobe)
-static constexpr uint16_t WarningChaseStepMs = 80;
-static constexpr uint16_t WarningChaseLaps = 5;
-static constexpr uint8_t WarningChaseWidth = 3;
-static constexpr uint16_t WarningStrobeStepMs = 60;
-static constexpr uint16_t WarningStrobeSteps = 14;
-static constexpr uint8_t WarningStrobeWhiteScale = 140; // 0-255 (lower = dimmer strobe)
-
-// Danger mode
-static constexpr uint16_t DangerChaseLaps = 5;
-static constexpr uint8_t DangerChaseWidth = 2;
-static constexpr uint16_t DangerChaseStepMs = 60;
-static constexpr uint16_t DangerPulseStepMs = 50;
-static constexpr uint16_t DangerPulseSteps = 60;
-static constexpr uint8_t DangerFlashEvery = 5;
-static constexpr uint8_t DangerPulseBase = 80;
-static constexpr uint16_t DangerPulseTrianglePeriod = 20;
-static constexpr uint16_t DangerCopStepMs = 140;
-static constexpr uint16_t DangerCopSteps = 30;
-
-// Common colors
-static constexpr uint8_t ColorYellowR = 255;
-static constexpr uint8_t ColorYellowG = 180;
-static constexpr uint8_t ColorYellowB = 0;
-
-static constexpr uint8_t ColorGreenR = 0;
-static constexpr uint8_t ColorGreenG = 255;
-static constexpr uint8_t ColorGreenB = 0;
-
-static constexpr uint8_t ColorRedR = 255;
-static constexpr uint8_t ColorRedG = 0;
-static constexpr uint8_t ColorRedB = 0;
-
-static constexpr uint8_t ColorBlueR = 0;
-static constexpr uint8_t ColorBlueG = 0;
-static constexpr uint8_t ColorBlueB = 255;
-
-static constexpr uint8_t ColorCyanR = 0;
-static constexpr uint8_t ColorCyanG = 255;
-static constexpr uint8_t ColorCyanB = 255;
-
-static constexpr uint8_t ColorPurpleR = 170;
-static constexpr uint8_t ColorPurpleG = 0;
-static constexpr uint8_t ColorPurpleB = 255;
-
-static constexpr uint8_t ColorWhiteR = 255;
-static constexpr uint8_t ColorWhiteG = 255;
-static constexpr uint8_t ColorWhiteB = 255;
-
-} // namespace Config
+#include "battery.h"
+#include "collar.h"
+#include "config.h"
+#include "flight_recorder.h"
+#include "phase_sync.h"
+#include "scheduler.h"
 
 namespace Log {
 
@@ -127,28 +18,104 @@ enum class Level : uint8_t {
 
 static constexpr Level MinLevel = Level::Info;
 
+// RAM ring buffer in front of Serial. While blocking (during setup) a full
+// buffer is flushed synchronously; afterwards overflowing lines are dropped.
+class Buffer : public Print {
+public:
+  size_t write(uint8_t b) override {
+    if (dropping) {
+      if (b == '\n') {
+        dropping = false;
+        if (used < Config::LogBufferBytes) {
+          push(b); // end the truncated line
+          return 1;
+        }
+      }
+      droppedBytes++;
+      return 1;
+    }
+
+    // The last slot is reserved for a newline so truncated lines still end.
+    const uint16_t limit = (b == '\n') ? Config::LogBufferBytes : (uint16_t)(Config::LogBufferBytes - 1);
+    if (used >= limit) {
+      if (blocking) {
+        drain(Config::LogBufferBytes);
+      } else {
+        dropping = (b != '\n');
+        droppedBytes++;
+        return 1;
+      }
+    }
+    push(b);
+    return 1;
+  }
+  using Print::write;
+
+  // Write up to maxBytes to Serial. Never blocks unless in blocking mode.
+  void drain(uint16_t maxBytes) {
+    uint16_t n = used;
+    if (n > maxBytes) {
+      n = maxBytes;
+    }
+    if (!blocking) {
+      const int room = Serial.availableForWrite();
+      if (room <= 0) {
+        return;
+      }
+      if (n > (uint16_t)room) {
+        n = (uint16_t)room;
+      }
+    }
+    while (n--) {
+      Serial.write(data[head]);
+      head = (uint16_t)((head + 1) % Config::LogBufferBytes);
+      used--;
+    }
+  }
+
+  void setBlocking(bool enable) { blocking = enable; }
+  uint16_t pending() const { return used; }
+  uint16_t room() const { return (uint16_t)(Config::LogBufferBytes - used); }
+  uint32_t dropped() const { return droppedBytes; }
+
+private:
+  void push(uint8_t b) {
+    data[(head + used) % Config::LogBufferBytes] = b;
+    used++;
+  }
+
+  uint8_t data[Config::LogBufferBytes];
+  uint16_t head = 0;
+  uint16_t used = 0;
+  uint32_t droppedBytes = 0;
+  bool blocking = true;
+  bool dropping = false;
+};
+
+static Buffer out;
+
 static bool isEnabled(Level level) {
   return static_cast<uint8_t>(level) <= static_cast<uint8_t>(MinLevel);
 }
 
 static void printPrefix(Level level) {
-  Serial.print('[');
-  Serial.print(millis());
-  Serial.print(F("ms] "));
+  Log::out.print('[');
+  Log::out.print(millis());
+  Log::out.print(F("ms] "));
 
   switch (level) {
     case Level::Error:
-      Serial.print(F("[E] "));
+      Log::out.print(F("[E] "));
       break;
     case Level::Warn:
-      Serial.print(F("[W] "));
+      Log::out.print(F("[W] "));
       break;
     case Level::Info:
-      Serial.print(F("[I] "));
+      Log::out.print(F("[I] "));
       break;
     case Level::Debug:
     default:
-      Serial.print(F("[D] "));
+      Log::out.print(F("[D] "));
       break;
   }
 }
@@ -158,7 +125,7 @@ static void line(Level level, const __FlashStringHelper *msg) {
     return;
   }
   printPrefix(level);
-  Serial.println(msg);
+  Log::out.println(msg);
 }
 
 static void line(Level level, const char *msg) {
@@ -166,7 +133,7 @@ static void line(Level level, const char *msg) {
     return;
   }
   printPrefix(level);
-  Serial.println(msg);
+  Log::out.println(msg);
 }
 
 static void keyValue(Level level, const __FlashStringHelper *key, uint32_t value) {
@@ -174,9 +141,9 @@ static void keyValue(Level level, const __FlashStringHelper *key, uint32_t value
     return;
   }
   printPrefix(level);
-  Serial.print(key);
-  Serial.print(F(": "));
-  Serial.println(value);
+  Log::out.print(key);
+  Log::out.print(F(": "));
+  Log::out.println(value);
 }
 
 } // namespace Log
@@ -192,19 +159,38 @@ static constexpr uint8_t REMOTE_PIN_COUNT = Config::RemotePinCount;
 static const uint8_t REMOTE_PINS[REMOTE_PIN_COUNT] = {REMOTE_PIN_1, REMOTE_PIN_2, REMOTE_PIN_3, REMOTE_PIN_4};
 static const char *REMOTE_PIN_NAMES[REMOTE_PIN_COUNT] = {"REMOTE_PIN_1", "REMOTE_PIN_2", "REMOTE_PIN_3", "REMOTE_PIN_4"};
 
-static bool lastRemoteStates[REMOTE_PIN_COUNT];
-static bool remoteStatesInitialized = false;
+static Flight::Checkpoints flightStore;
+
+// WS2812 / NeoPixel data pin
+static constexpr uint8_t NEOPIXEL_PIN = Config::NeoPixelPin;
+
+#if defined(TAMECOLLAR_ADAFRUIT_NEOPIXEL)
+Adafruit_NeoPixel strip(PIXEL_COUNT, NEOPIXEL_PIN, NEO_GRB + NEO_KHZ800);
+#else
+PixelStrip strip;
+#endif
 
-static uint8_t remotePressEvents = 0;
+// This board's collar. Everything per-device lives in it; the rest of this
+// file is the hardware around it (pins, ports, EEPROM, log, sync link).
+static void printModeChange(LedMode m, Flight::Source source, void *user);
+static Collar collar(strip, printModeChange);
+static LedRingController &ring = collar.ring();
+static Flight::Recorder &flight = collar.flight();
 
 static void printRemotePinState(uint8_t index, bool isHigh) {
   Log::printPrefix(Log::Level::Info);
-  Serial.print(F("RADIO: "));
-  Serial.print(REMOTE_PIN_NAMES[index]);
-  Serial.print(F(" (pin "));
-  Serial.print(REMOTE_PINS[index]);
-  Serial.print(F(") is "));
-  Serial.println(isHigh ? F("HIGH") : F("LOW"));
+  Log::out.print(F("RADIO: "));
+  Log::out.print(REMOTE_PIN_NAMES[index]);
+  Log::out.print(F(" (pin "));
+  Log::out.print(REMOTE_PINS[index]);
+  Log::out.print(F(") is "));
+  Log::out.println(isHigh ? F("HIGH") : F("LOW"));
+}
+
+static void readRemotePins(bool *high) {
+  for (uint8_t i = 0; i < REMOTE_PIN_COUNT; i++) {
+    high[i] = (digitalRead(REMOTE_PINS[i]) == HIGH);
+  }
 }
 
 static void initRemotePins() {
@@ -212,724 +198,607 @@ static void initRemotePins() {
     pinMode(REMOTE_PINS[i], INPUT_PULLUP);
   }
 
+  bool high[REMOTE_PIN_COUNT];
+  readRemotePins(high);
+  collar.beginRemotes(high);
   for (uint8_t i = 0; i < REMOTE_PIN_COUNT; i++) {
-    const bool isHigh = (digitalRead(REMOTE_PINS[i]) == HIGH);
-    lastRemoteStates[i] = isHigh;
-    printRemotePinState(i, isHigh);
+    printRemotePinState(i, high[i]);
   }
-
-  remoteStatesInitialized = true;
 }
 
-static void pollRemotePinsForChanges() {
-  if (!remoteStatesInitialized) {
-    return;
-  }
-
+static void pollRemotePinsForChanges(uint32_t nowMs) {
+  bool high[REMOTE_PIN_COUNT];
+  readRemotePins(high);
+  const uint8_t changed = collar.pollRemotes(high, nowMs);
   for (uint8_t i = 0; i < REMOTE_PIN_COUNT; i++) {
-    const bool isHigh = (digitalRead(REMOTE_PINS[i]) == HIGH);
-    if (isHigh != lastRemoteStates[i]) {
-      const bool wasHigh = lastRemoteStates[i];
-      lastRemoteStates[i] = isHigh;
-      printRemotePinState(i, isHigh);
-
-      // With INPUT_PULLUP: pressed = LOW. Trigger actions on press (HIGH -> LOW).
-      if (wasHigh && !isHigh) {
-        remotePressEvents |= (uint8_t)(1u << i);
-      }
+    if (changed & (1u << i)) {
+      printRemotePinState(i, high[i]);
     }
   }
 }
 
-// WS2812 / NeoPixel data pin
-static constexpr uint8_t NEOPIXEL_PIN = Config::NeoPixelPin;
-static constexpr uint16_t PIXEL_COUNT = Config::PixelCount;
-
-static constexpr uint8_t STRIP_BRIGHTNESS = Config::StripBrightness; // 0-255
+// Phase sync with other collars (Config::SyncRoleSetting). The ring always
+// runs on animation time; with sync off that is just millis().
+static constexpr bool kSyncEnabled = Config::SyncRoleSetting != Config::SyncRole::Off;
+static constexpr bool kSyncLeader = Config::SyncRoleSetting == Config::SyncRole::Leader;
+static Sync::Leader syncLeader;
+static Sync::Follower syncFollower;
+static Sync::BeaconParser syncParser;
 
-// Ring mapping convention (as requested):
-// - LED 1 is the top-right
-// - LEDs increase clockwise
-// - LED 8 is the top-left
-// In code, we use 0-based indices: LED1 -> index 0, LED8 -> index 7.
-
-
-Adafruit_NeoPixel strip(PIXEL_COUNT, NEOPIXEL_PIN, NEO_GRB + NEO_KHZ800);
-
-enum class LedMode : uint8_t {
-  Idle = 1,
-  Peace = 2,
-  Warning = 3,
-  Danger = 4,
-  SolidGreen = 5,
-  SolidYellow = 6,
-  SolidRed = 7,
-};
-
-static uint32_t scaleColor(Adafruit_NeoPixel &s, uint32_t color, uint8_t scale) {
-  // Adafruit_NeoPixel::Color() packs colors as 0x00RRGGBB.
-  const uint8_t r0 = (uint8_t)((color >> 16) & 0xFF);
-  const uint8_t g0 = (uint8_t)((color >> 8) & 0xFF);
-  const uint8_t b0 = (uint8_t)(color & 0xFF);
-
-  const uint8_t r = (uint8_t)((uint16_t)r0 * scale / 255);
-  const uint8_t g = (uint8_t)((uint16_t)g0 * scale / 255);
-  const uint8_t b = (uint8_t)((uint16_t)b0 * scale / 255);
-  return s.Color(r, g, b);
+static uint32_t animationNowMs(uint32_t nowMs) {
+  if (!kSyncEnabled) {
+    return nowMs;
+  }
+  return kSyncLeader ? syncLeader.animNow(nowMs) : syncFollower.animNow(nowMs);
 }
 
-static uint8_t triangleWave8(uint16_t step, uint16_t periodSteps) {
-  if (periodSteps < 2) {
-    return 255;
+static const __FlashStringHelper *modeName(LedMode m) {
+  switch (m) {
+    case LedMode::Idle:
+      return F("Idle");
+    case LedMode::Peace:
+      return F("Peace");
+    case LedMode::Warning:
+      return F("Warning");
+    case LedMode::Danger:
+      return F("Danger");
+    case LedMode::SolidGreen:
+      return F("SolidGreen");
+    case LedMode::SolidYellow:
+      return F("SolidYellow");
+    case LedMode::SolidRed:
+      return F("SolidRed");
+    default:
+      return F("Unknown");
   }
+}
 
-  const uint16_t p = step % periodSteps;
-  const uint16_t half = periodSteps / 2;
-  if (p <= half) {
-    return (uint8_t)((uint32_t)p * 255 / half);
+// Help text, one line per call so it can be emitted a line at a time from the
+// report task. Returns false past the last line.
+static bool printSerialHelpLine(uint8_t line) {
+  switch (line) {
+    case 0:
+      Log::line(Log::Level::Info, F("Serial commands:"));
+      return true;
+    case 1:
+      Log::line(Log::Level::Info, F("  1 = Idle"));
+      return true;
+    case 2:
+      Log::line(Log::Level::Info, F("  2 = Peace"));
+      return true;
+    case 3:
+      Log::line(Log::Level::Info, F("  3 = Warning"));
+      return true;
+    case 4:
+      Log::line(Log::Level::Info, F("  4 = Danger"));
+      return true;
+    case 5:
+      Log::line(Log::Level::Info, F("  t = task timing stats"));
+      return true;
+    case 6:
+      Log::line(Log::Level::Info, F("  f = flight recorder dump"));
+      return true;
+    case 7:
+      Log::line(Log::Level::Info, F("  h or ? = this help"));
+      return true;
+    default:
+      return false;
   }
-  return (uint8_t)((uint32_t)(periodSteps - p) * 255 / half);
 }
 
-static uint32_t wheel(Adafruit_NeoPixel &s, uint8_t wheelPos) {
-  wheelPos = (uint8_t)(255 - wheelPos);
-  if (wheelPos < 85) {
-    return s.Color(255 - wheelPos * 3, 0, wheelPos * 3);
-  }
-  if (wheelPos < 170) {
-    wheelPos = (uint8_t)(wheelPos - 85);
-    return s.Color(0, wheelPos * 3, 255 - wheelPos * 3);
+static void printSerialHelp() {
+  for (uint8_t i = 0; printSerialHelpLine(i); i++) {
   }
-  wheelPos = (uint8_t)(wheelPos - 170);
-  return s.Color(wheelPos * 3, 255 - wheelPos * 3, 0);
 }
 
-class LedRingController {
-public:
-  explicit LedRingController(Adafruit_NeoPixel &s) : strip(s) {}
+static void printStartupBanner() {
+  Log::line(Log::Level::Info, F("TameCollar firmware boot"));
+  Log::line(Log::Level::Info, F("Source: https://github.com/zebadrabbit/TameCollar"));
+  Log::keyValue(Log::Level::Info, F("Serial baud"), Config::SerialBaud);
 
-  void begin() {
-    strip.begin();
-    strip.setBrightness(STRIP_BRIGHTNESS);
-    strip.clear();
-    strip.show();
+  Log::line(Log::Level::Info, F("What you'll see in Serial output:"));
+  Log::line(Log::Level::Info, F("  - Boot banner + pin/config summary"));
+  Log::line(Log::Level::Info, F("  - RADIO: remote input transitions (HIGH/LOW)"));
+  Log::line(Log::Level::Info, F("  - MODE: changes (via remote or serial)"));
+  if (Config::SerialHeartbeatMs != 0) {
+    Log::line(Log::Level::Info, F("  - HEARTBEAT: periodic status line"));
+  }
+  if (kSyncEnabled) {
+    Log::line(Log::Level::Info, kSyncLeader ? F("  - SYNC: leader, beacons on Serial1")
+                                            : F("  - SYNC: follower, tracking beacons on Serial1"));
   }
 
-  LedMode mode() const { return currentMode; }
+  Log::line(Log::Level::Info, F("Hardware defaults (" TAMECOLLAR_VARIANT_NAME "):"));
+  Log::printPrefix(Log::Level::Info);
+  Log::out.print(F("  NeoPixel pin="));
+  Log::out.print(NEOPIXEL_PIN);
+  Log::out.print(F(", pixels="));
+  Log::out.print(PIXEL_COUNT);
+  Log::out.print(F(", brightness="));
+  Log::out.println(STRIP_BRIGHTNESS);
 
-  void setMode(LedMode newMode, bool forceRestart = false) {
-    if (!forceRestart && newMode == currentMode) {
-      return;
-    }
+  Log::line(Log::Level::Info, F("Remote inputs use INPUT_PULLUP (pressed = LOW)."));
+  printSerialHelp();
+}
 
-    currentMode = newMode;
-    restartAnimation();
-    resetPowerCycle();
-  }
+static void printMode(LedMode m) {
+  Log::printPrefix(Log::Level::Info);
+  Log::out.print(F("MODE: "));
+  Log::out.println(modeName(m));
+}
 
-  void restartAnimation() {
-    phase = 0;
-    step = 0;
-    lastTickMs = 0;
-    idleCleared = false;
-  }
+static void printModeChange(LedMode m, Flight::Source source, void *user) {
+  (void)source;
+  (void)user;
+  printMode(m);
+}
 
-  void resetPowerCycle() {
-    powerState = PowerState::Active;
-    activeCyclesDone = 0;
-    powerStateStartMs = 0;
-    powerOffCleared = false;
-    strip.setBrightness(baseBrightness);
+// Serial mode-command acknowledgement (Config::SerialModeAck). Sent from the
+// frame task once the ring has shown a frame in the new mode; a command that
+// doesn't change the mode is acknowledged at once. A newer command before the
+// frame replaces the pending one, which is then never acknowledged.
+static constexpr uint8_t kAckByte = 0x06;
+static char pendingAck = 0;
+static uint16_t ackFramesMark = 0;
+
+static void sendAck(char command) {
+  // Never block the loop for it; the console times out instead.
+  if (Serial.availableForWrite() < 2) {
+    return;
   }
+  Serial.write(kAckByte);
+  Serial.write((uint8_t)command);
+}
 
-  void update(uint32_t nowMs) {
-    // Danger stays on continuously (no power-saving loop).
-    if (currentMode == LedMode::Danger) {
-      strip.setBrightness(baseBrightness);
-      updateDanger(nowMs);
-      return;
-    }
-
-    // Idle is already off.
-    if (currentMode == LedMode::Idle) {
-      strip.setBrightness(baseBrightness);
-      updateIdle();
-      return;
-    }
+static void applySerialMode(LedMode m, char command) {
+  const bool changed = ring.mode() != m;
+  collar.applyMode(m, Flight::Source::Serial, millis());
+  if (!Config::SerialModeAck) {
+    return;
+  }
+  if (!changed) {
+    sendAck(command);
+    return;
+  }
+  pendingAck = command;
+  ackFramesMark = ring.framesShown();
+}
 
-    if (powerStateStartMs == 0) {
-      powerStateStartMs = nowMs;
-    }
+// ----------------------------
+// Main-loop tasks
+// ----------------------------
+// Table order is priority order: frame output and input capture first,
+// logging and heartbeat last.
+enum class TaskId : uint8_t {
+  Frame = 0,
+  Input = 1,
+  RemoteEvents = 2,
+  Sync = 3,
+  SerialCommands = 4,
+  Battery = 5,
+  Heartbeat = 6,
+  LogOutput = 7,
+  Report = 8,
+  FlightCheckpoint = 9,
+};
 
-    switch (powerState) {
-      case PowerState::Sleeping: {
-        if (!powerOffCleared) {
-          strip.setBrightness(baseBrightness);
-          strip.clear();
-          show();
-          powerOffCleared = true;
-        }
+static bool runFrameTask(const Sched::TaskContext &ctx);
+static bool runInputTask(const Sched::TaskContext &ctx);
+static bool runRemoteEventTask(const Sched::TaskContext &ctx);
+static bool runSyncTask(const Sched::TaskContext &ctx);
+static bool runSerialTask(const Sched::TaskContext &ctx);
+static bool runBatteryTask(const Sched::TaskContext &ctx);
+static bool runHeartbeatTask(const Sched::TaskContext &ctx);
+static bool runLogTask(const Sched::TaskContext &ctx);
+static bool runReportTask(const Sched::TaskContext &ctx);
+static bool runFlightTask(const Sched::TaskContext &ctx);
+
+static_assert(Config::SerialHeartbeatMs <= 0xFFFFu, "SerialHeartbeatMs must fit a task period (uint16_t)");
+
+static constexpr Sched::TaskSpec kTasks[] = {
+    {"frame", runFrameTask, 0, Config::FrameTaskPeriodMs, Config::FrameTaskBudgetUs},
+    {"input", runInputTask, 1, Config::InputTaskPeriodMs, Config::InputTaskBudgetUs},
+    {"remote", runRemoteEventTask, 2, 0, Config::RemoteEventTaskBudgetUs},
+    {"sync", runSyncTask, 3, kSyncEnabled ? 1 : 0, Config::SyncTaskBudgetUs},
+    {"serial", runSerialTask, 4, Config::SerialTaskPeriodMs, Config::SerialTaskBudgetUs},
+    {"battery", runBatteryTask, 5, Config::BatteryAdaptive ? Config::BatterySampleMs : 0, Config::BatteryTaskBudgetUs},
+    {"heartbeat", runHeartbeatTask, 6, (uint16_t)Config::SerialHeartbeatMs, Config::HeartbeatTaskBudgetUs},
+    {"log", runLogTask, 7, Config::LogTaskPeriodMs, Config::LogTaskBudgetUs},
+    {"report", runReportTask, 8, Config::ReportTaskPeriodMs, Config::ReportTaskBudgetUs},
+    {"flight", runFlightTask, 9, Config::FlightTaskPeriodMs, Config::FlightTaskBudgetUs},
+};
+static constexpr uint8_t kTaskCount = sizeof(kTasks) / sizeof(kTasks[0]);
+static_assert(Sched::prioritiesSorted(kTasks, kTaskCount), "kTasks must be listed in priority order");
+
+static Sched::Scheduler<kTaskCount> scheduler(kTasks);
+
+// Multi-line serial output (help, task stats) is emitted a line at a time by
+// the report task, only when the log buffer has room for it.
+enum class Report : uint8_t {
+  None = 0,
+  Help = 1,
+  TaskStats = 2,
+  Flight = 3,
+};
 
-        if (nowMs - powerStateStartMs >= kSleepMs) {
-          powerState = PowerState::Active;
-          powerStateStartMs = nowMs;
-          powerOffCleared = false;
-          strip.setBrightness(baseBrightness);
-          activeCyclesDone = 0;
-          restartAnimation();
-        }
-        return;
-      }
+static Report activeReport = Report::None;
+static uint8_t reportLine = 0;
 
-      case PowerState::FadingOut: {
-        const uint32_t elapsed = nowMs - powerStateStartMs;
-        if (elapsed >= kFadeMs) {
-          strip.setBrightness(baseBrightness);
-          strip.clear();
-          show();
-
-          powerState = PowerState::Sleeping;
-          powerStateStartMs = nowMs;
-          powerOffCleared = true;
-          return;
-        }
+static void startReport(Report report) {
+  activeReport = report;
+  reportLine = 0;
+}
 
-        const uint16_t remaining = (uint16_t)(kFadeMs - elapsed);
-        const uint8_t b = (uint8_t)((uint32_t)baseBrightness * remaining / kFadeMs);
-        strip.setBrightness(b);
-        show();
-        return;
-      }
+static bool printTaskStatsLine(uint8_t line) {
+  if (line < kTaskCount) {
+    const Sched::TaskSpec &spec = scheduler.spec(line);
+    const Sched::TaskStats &s = scheduler.taskStats(line);
+    Log::printPrefix(Log::Level::Info);
+    Log::out.print(F("TASK "));
+    Log::out.print(spec.name);
+    Log::out.print(F(": runs="));
+    Log::out.print(s.runs);
+    Log::out.print(F(" avgUs="));
+    Log::out.print(s.runs ? s.totalUs / s.runs : 0);
+    Log::out.print(F(" maxUs="));
+    Log::out.print(s.maxUs);
+    Log::out.print(F(" overruns="));
+    Log::out.print(s.overruns);
+    Log::out.print(F(" maxLateMs="));
+    Log::out.println(s.maxLateMs);
+    return true;
+  }
+  if (line == kTaskCount) {
+    Log::keyValue(Log::Level::Info, F("LOG: dropped bytes"), Log::out.dropped());
+    return true;
+  }
+  return false;
+}
 
-      case PowerState::Active:
-      default: {
-        strip.setBrightness(baseBrightness);
-
-        bool cycleDone = false;
-        switch (currentMode) {
-          case LedMode::Peace:
-            cycleDone = updatePeace(nowMs);
-            break;
-          case LedMode::Warning:
-            cycleDone = updateWarning(nowMs);
-            break;
-          case LedMode::SolidGreen:
-            cycleDone = updateSolidColor(nowMs, strip.Color(Config::ColorGreenR, Config::ColorGreenG, Config::ColorGreenB));
-            break;
-          case LedMode::SolidYellow:
-            cycleDone = updateSolidColor(nowMs, strip.Color(Config::ColorYellowR, Config::ColorYellowG, Config::ColorYellowB));
-            break;
-          case LedMode::SolidRed:
-            cycleDone = updateSolidColor(nowMs, strip.Color(Config::ColorRedR, Config::ColorRedG, Config::ColorRedB));
-            break;
-          default:
-            // Should not happen (Idle/Danger handled above)
-            break;
-        }
+static const __FlashStringHelper *powerStateName(uint8_t s) {
+  switch (s) {
+    case 0:
+      return F("Active");
+    case 1:
+      return F("FadingOut");
+    case 2:
+      return F("Sleeping");
+    default:
+      return F("Unknown");
+  }
+}
 
-        if (cycleDone) {
-          activeCyclesDone++;
-          if (activeCyclesDone >= activeCyclesTarget()) {
-            powerState = PowerState::FadingOut;
-            powerStateStartMs = nowMs;
-          } else {
-            restartAnimation();
-          }
-        }
-        return;
-      }
-    }
+static const __FlashStringHelper *batteryTierName(Battery::Tier t) {
+  switch (t) {
+    case Battery::Tier::Normal:
+      return F("Normal");
+    case Battery::Tier::Low:
+      return F("Low");
+    case Battery::Tier::Critical:
+      return F("Critical");
+    default:
+      return F("Unknown");
   }
+}
 
-private:
-  Adafruit_NeoPixel &strip;
-  LedMode currentMode = LedMode::Idle;
-
-  enum class PowerState : uint8_t {
-    Active = 0,
-    FadingOut = 1,
-    Sleeping = 2,
-  };
-
-  static constexpr uint32_t kSleepMs = Config::SleepMs;
-  static constexpr uint32_t kFadeMs = Config::FadeMs;
-  static constexpr uint8_t baseBrightness = STRIP_BRIGHTNESS;
-
-  uint8_t activeCyclesTarget() const {
-    uint8_t target = Config::ActiveCycles;
-    switch (currentMode) {
-      case LedMode::Peace:
-        target = Config::ActiveCyclesPeace;
+static void printResetCause(uint8_t flags) {
+  if (flags == 0) {
+    Log::out.print(F("unknown"));
+    return;
+  }
+  static const uint8_t kBits[] = {PORF, EXTRF, BORF, WDRF};
+  bool first = true;
+  for (uint8_t i = 0; i < sizeof(kBits); i++) {
+    if (!(flags & (1u << kBits[i]))) {
+      continue;
+    }
+    if (!first) {
+      Log::out.print('+');
+    }
+    first = false;
+    switch (i) {
+      case 0:
+        Log::out.print(F("power-on"));
         break;
-      case LedMode::Warning:
-        target = Config::ActiveCyclesWarning;
+      case 1:
+        Log::out.print(F("external"));
         break;
-      case LedMode::SolidGreen:
-      case LedMode::SolidYellow:
-      case LedMode::SolidRed:
-        target = Config::ActiveCyclesSolid;
+      case 2:
+        Log::out.print(F("brown-out"));
         break;
       default:
-        target = Config::ActiveCycles;
+        Log::out.print(F("watchdog"));
         break;
     }
-
-    // Avoid a "0 cycles" configuration that would immediately fade out.
-    return (target == 0) ? 1 : target;
   }
+}
 
-  PowerState powerState = PowerState::Active;
-  uint8_t activeCyclesDone = 0;
-  uint32_t powerStateStartMs = 0;
-  bool powerOffCleared = false;
-
-  // Shared animation state
-  uint8_t phase = 0;
-  uint16_t step = 0;
-  uint32_t lastTickMs = 0;
-  bool idleCleared = false;
-
-  void show() { strip.show(); }
-
-  void setAll(uint32_t color) {
-    for (uint16_t i = 0; i < PIXEL_COUNT; i++) {
-      strip.setPixelColor(i, color);
+static void printFlightEntry(bool previousSession, const Flight::Entry &e) {
+  Log::printPrefix(Log::Level::Info);
+  Log::out.print(previousSession ? F("FLIGHT prev ") : F("FLIGHT now "));
+  Log::out.print(e.ms);
+  Log::out.print(F("ms "));
+  switch (e.event) {
+    case Flight::Event::Boot:
+      Log::out.print(F("BOOT reset="));
+      printResetCause(e.arg);
+      break;
+    case Flight::Event::Mode: {
+      static const char *const kSources[] = {"remote", "serial", "sync"};
+      const uint8_t source = (uint8_t)(e.arg >> 4);
+      Log::out.print(F("MODE "));
+      Log::out.print(modeName(static_cast<LedMode>(e.arg & 0x0F)));
+      Log::out.print(F(" via "));
+      Log::out.print(source < 3 ? kSources[source] : "?");
+      break;
     }
+    case Flight::Event::RemoteEdge:
+      Log::out.print(F("RADIO remote "));
+      Log::out.print((uint8_t)((e.arg & 0x7F) + 1));
+      Log::out.print((e.arg & 0x80) ? F(" HIGH") : F(" LOW"));
+      break;
+    case Flight::Event::Power:
+      Log::out.print(F("POWER "));
+      Log::out.print(powerStateName(e.arg));
+      break;
+    case Flight::Event::Battery:
+      Log::out.print(F("BATTERY "));
+      Log::out.print(batteryTierName(static_cast<Battery::Tier>(e.arg)));
+      break;
+    default:
+      Log::out.print(F("? "));
+      Log::out.print(e.arg);
+      break;
   }
+  Log::out.println();
+}
 
-  void chaseSingle(uint32_t color, uint8_t pos) {
-    strip.clear();
-    strip.setPixelColor(pos % PIXEL_COUNT, color);
-  }
+// Previous session (last EEPROM checkpoint before this boot), then this
+// session's RAM ring, each oldest first.
+static uint16_t flightDumpTotal = 0;
+static uint8_t flightDumpCount = 0;
 
-  void chaseSegment(uint32_t color, uint8_t headPos, uint8_t width) {
-    strip.clear();
-    for (uint8_t w = 0; w < width; w++) {
-      strip.setPixelColor((headPos + w) % PIXEL_COUNT, color);
+static bool printFlightLine(uint8_t line) {
+  const uint8_t prev = flightStore.previousCount();
+  if (line == 0) {
+    Log::printPrefix(Log::Level::Info);
+    if (flightStore.hasPrevious()) {
+      Log::out.print(F("FLIGHT: previous session, events="));
+      Log::out.println(prev);
+    } else {
+      Log::out.println(F("FLIGHT: no previous session in EEPROM"));
     }
+    return true;
   }
-
-  void updateIdle() {
-    if (idleCleared) {
-      return;
-    }
-    strip.clear();
-    show();
-    idleCleared = true;
-  }
-
-  bool updateSolidColor(uint32_t nowMs, uint32_t color) {
-    // One cycle = show solid color briefly.
-    if (phase == 0) {
-      setAll(color);
-      show();
-      phase = 1;
-      lastTickMs = nowMs;
-      return false;
-    }
-
-    if (nowMs - lastTickMs < Config::SolidHoldMs) {
-      return false;
-    }
-
+  if (line <= prev) {
+    printFlightEntry(true, flightStore.previous((uint8_t)(prev - line)));
     return true;
   }
-
-  // Mode 2: Peace - multiple phases, all green-focused.
-  bool updatePeace(uint32_t nowMs) {
-    const uint32_t green = strip.Color(Config::ColorGreenR, Config::ColorGreenG, Config::ColorGreenB);
-    const uint32_t dimGreen = scaleColor(strip, green, Config::PeaceBackgroundScale);
-    const uint32_t blue = strip.Color(Config::ColorBlueR, Config::ColorBlueG, Config::ColorBlueB);
-    const uint32_t cyan = strip.Color(Config::ColorCyanR, Config::ColorCyanG, Config::ColorCyanB);
-    const uint32_t purple = strip.Color(Config::ColorPurpleR, Config::ColorPurpleG, Config::ColorPurpleB);
-
-    // phase 0: calm green chase over dim green background
-    if (phase == 0) {
-      if (nowMs - lastTickMs < Config::PeaceChaseStepMs) {
-        return false;
-      }
-      lastTickMs = nowMs;
-
-      const uint8_t pos = (uint8_t)(step % PIXEL_COUNT);
-      setAll(dimGreen);
-      for (uint8_t w = 0; w < Config::PeaceChaseWidth; w++) {
-        strip.setPixelColor((pos + w) % PIXEL_COUNT, green);
-      }
-      show();
-
-      step++;
-      if (step >= Config::PeaceChaseSteps) {
-        phase = 1;
-        step = 0;
-        lastTickMs = nowMs;
-      }
-      return false;
-    }
-
-    // phase 1: green "breathing" pulse
-    if (phase == 1) {
-      if (nowMs - lastTickMs < Config::PeacePulseStepMs) {
-        return false;
-      }
-      lastTickMs = nowMs;
-
-      const uint8_t wave = triangleWave8(step, Config::PeacePulseSteps);
-      const uint16_t span = (uint16_t)(Config::PeacePulseMaxScale - Config::PeacePulseMinScale);
-      const uint8_t intensity = (uint8_t)(Config::PeacePulseMinScale + (uint32_t)span * wave / 255);
-      setAll(scaleColor(strip, green, intensity));
-      show();
-
-      step++;
-      if (step >= Config::PeacePulseSteps) {
-        phase = 2;
-        step = 0;
-        lastTickMs = nowMs;
-      }
-      return false;
-    }
-
-    // phase 2: soft sparkles (bright green points over dim green)
-    if (phase == 2) {
-      if (nowMs - lastTickMs < Config::PeaceSparkleStepMs) {
-        return false;
-      }
-      lastTickMs = nowMs;
-
-      setAll(dimGreen);
-      const uint32_t sparkleGreen = scaleColor(strip, green, Config::PeaceSparkleScale);
-      const uint32_t sprinkleBlue = scaleColor(strip, blue, Config::PeaceSprinkleScale);
-      const uint32_t sprinkleCyan = scaleColor(strip, cyan, Config::PeaceSprinkleScale);
-      const uint32_t sprinklePurple = scaleColor(strip, purple, Config::PeaceSprinkleScale);
-      for (uint8_t j = 0; j < Config::PeaceSparkleCount; j++) {
-        const uint8_t idx = (uint8_t)((step * 3u + j * 5u) % PIXEL_COUNT);
-        // Mostly green sparkles, with occasional blue/cyan/purple "sprinkles".
-        const uint8_t sel = (uint8_t)((step + j * 3u) % 12u);
-        uint32_t c = sparkleGreen;
-        if (sel == 0) {
-          c = sprinkleCyan;
-        } else if (sel == 1) {
-          c = sprinklePurple;
-        } else if (sel == 2) {
-          c = sprinkleBlue;
-        }
-        strip.setPixelColor(idx, c);
-      }
-      show();
-
-      step++;
-      if (step >= Config::PeaceSparkleSteps) {
-        phase = 3;
-        step = 0;
-        lastTickMs = nowMs;
-      }
-      return false;
-    }
-
-    // phase 3: brief solid green hold, then complete cycle
-    if (phase == 3) {
-      if (step == 0) {
-        setAll(green);
-        show();
-        step = 1;
-        lastTickMs = nowMs;
-        return false;
-      }
-
-      if (nowMs - lastTickMs < Config::PeaceHoldMs) {
-        return false;
-      }
-
-      return true;
-    }
-
+  if (line == prev + 1) {
+    flightDumpTotal = flight.recorded();
+    flightDumpCount = flight.count();
+    Log::printPrefix(Log::Level::Info);
+    Log::out.print(F("FLIGHT: this session, events="));
+    Log::out.print(flightDumpCount);
+    Log::out.print(F(" lost="));
+    Log::out.println(flight.lost());
+    return true;
+  }
+  const uint8_t k = (uint8_t)(line - prev - 2);
+  if (k >= flightDumpCount) {
     return false;
   }
+  // Events recorded since the header shift the ring; skip any pushed out.
+  const uint16_t age = (uint16_t)(flight.recorded() - flightDumpTotal + (flightDumpCount - 1 - k));
+  if (age < flight.count()) {
+    printFlightEntry(false, flight.newest((uint8_t)age));
+  }
+  return true;
+}
 
-  // Mode 3: Warning (moved from former De-escalate)
-  // Warning-y yellow hazard chase with occasional white strobes.
-  bool updateWarning(uint32_t nowMs) {
-    const uint32_t yellow = strip.Color(Config::ColorYellowR, Config::ColorYellowG, Config::ColorYellowB);
-    const uint32_t white = strip.Color(Config::ColorWhiteR, Config::ColorWhiteG, Config::ColorWhiteB);
-
-    // phase 0: yellow "hazard" chase around the ring
-    if (phase == 0) {
-      const uint16_t stepsTotal = (uint16_t)(Config::WarningChaseLaps * PIXEL_COUNT);
-      if (nowMs - lastTickMs < Config::WarningChaseStepMs) {
-        return false;
-      }
-      lastTickMs = nowMs;
-
-      chaseSegment(yellow, (uint8_t)(step % PIXEL_COUNT), Config::WarningChaseWidth);
-      show();
-
-      step++;
-      if (step >= stepsTotal) {
-        phase = 1;
-        step = 0;
-        lastTickMs = nowMs;
-      }
-      return false;
-    }
-
-    // phase 1: brief white strobes alternating with yellow for drama
-    if (phase == 1) {
-      if (nowMs - lastTickMs < Config::WarningStrobeStepMs) {
-        return false;
-      }
-      lastTickMs = nowMs;
-
-      // "Police light" style: split the ring in half. One half is solid yellow,
-      // the other half is the dimmed white strobe. Swap sides each step.
-      const uint32_t dimWhite = scaleColor(strip, white, Config::WarningStrobeWhiteScale);
-      const bool swap = (step % 2) == 1;
-      for (uint16_t i = 0; i < PIXEL_COUNT; i++) {
-        const bool firstHalf = i < (PIXEL_COUNT / 2);
-        const bool whiteSide = (firstHalf ^ swap);
-        strip.setPixelColor(i, whiteSide ? dimWhite : yellow);
-      }
-      show();
+static void pollSerialForModeChange() {
+  if (!Serial.available()) {
+    return;
+  }
 
-      step++;
-      if (step >= Config::WarningStrobeSteps) {
-        return true;
-      }
-      return false;
-    }
+  const char c = (char)Serial.read();
+  if (c == 'h' || c == 'H' || c == '?') {
+    startReport(Report::Help);
+    return;
+  }
+  if (c == 't' || c == 'T') {
+    startReport(Report::TaskStats);
+    return;
+  }
 
-    return true;
+  if (c == 'f' || c == 'F') {
+    startReport(Report::Flight);
+    return;
   }
 
-  // Mode 4: red chase, then fast flash/pulse, then cop-lights (4 red, 4 blue) alternating.
-  void updateDanger(uint32_t nowMs) {
-    const uint32_t red = strip.Color(Config::ColorRedR, Config::ColorRedG, Config::ColorRedB);
-    const uint32_t blue = strip.Color(Config::ColorBlueR, Config::ColorBlueG, Config::ColorBlueB);
+  if (c == '1') {
+    applySerialMode(LedMode::Idle, c);
+  } else if (c == '2') {
+    applySerialMode(LedMode::Peace, c);
+  } else if (c == '3') {
+    applySerialMode(LedMode::Warning, c);
+  } else if (c == '4') {
+    applySerialMode(LedMode::Danger, c);
+  } else if (c != '\n' && c != '\r') {
+    Log::printPrefix(Log::Level::Warn);
+    Log::out.print(F("Unknown command: '"));
+    Log::out.print(c);
+    Log::out.println(F("' (send 'h' for help)"));
+  }
+}
 
-    // phase 0: fast red chase
-    if (phase == 0) {
-      const uint16_t stepsTotal = (uint16_t)(Config::DangerChaseLaps * PIXEL_COUNT);
-      if (nowMs - lastTickMs < Config::DangerChaseStepMs) {
-        return;
-      }
-      lastTickMs = nowMs;
+static bool runFrameTask(const Sched::TaskContext &ctx) {
+  collar.update(animationNowMs(ctx.nowMs), ctx.nowMs);
+  if (pendingAck != 0 && ring.framesShown() != ackFramesMark) {
+    sendAck(pendingAck);
+    pendingAck = 0;
+  }
+  return false;
+}
 
-      chaseSegment(red, (uint8_t)(step % PIXEL_COUNT), Config::DangerChaseWidth);
-      show();
+static bool runInputTask(const Sched::TaskContext &ctx) {
+  pollRemotePinsForChanges(ctx.nowMs);
+  if (collar.pendingGestures()) {
+    scheduler.signal(static_cast<uint8_t>(TaskId::RemoteEvents));
+  }
+  return false;
+}
 
-      step++;
-      if (step >= stepsTotal) {
-        phase = 1;
-        step = 0;
-        lastTickMs = nowMs;
-      }
-      return;
+// e.g. "RADIO: chord REMOTE_PIN_1+REMOTE_PIN_3 after 12ms"
+static void printGesture(const Collar::Gestures::Fired &g) {
+  static const char *const kGestures[] = {"?", "tap", "double", "long", "chord"};
+  const uint8_t kind = static_cast<uint8_t>(g.gesture);
+  Log::printPrefix(Log::Level::Info);
+  Log::out.print(F("RADIO: "));
+  Log::out.print(kind < 5 ? kGestures[kind] : "?");
+  char sep = ' ';
+  for (uint8_t i = 0; i < REMOTE_PIN_COUNT; i++) {
+    if (g.buttons & (1u << i)) {
+      Log::out.print(sep);
+      Log::out.print(REMOTE_PIN_NAMES[i]);
+      sep = '+';
     }
+  }
+  Log::out.print(F(" after "));
+  Log::out.print(g.atMs - g.startMs);
+  Log::out.println(F("ms"));
+}
 
-    // phase 1: flash/pulse red quickly
-    if (phase == 1) {
-      if (nowMs - lastTickMs < Config::DangerPulseStepMs) {
-        return;
-      }
-      lastTickMs = nowMs;
-
-      const bool flash = (step % Config::DangerFlashEvery) == 0;
-      const uint8_t intensity =
-          flash ? 255 : (uint8_t)(Config::DangerPulseBase + triangleWave8(step, Config::DangerPulseTrianglePeriod) / 2);
-      setAll(scaleColor(strip, red, intensity));
-      show();
-
-      step++;
-      if (step >= Config::DangerPulseSteps) {
-        phase = 2;
-        step = 0;
-        lastTickMs = nowMs;
-      }
-      return;
-    }
+// One gesture per run; a chord and a tap in the same pass take two.
+static bool runRemoteEventTask(const Sched::TaskContext &ctx) {
+  Collar::Gestures::Fired g;
+  if (collar.takeGesture(g)) {
+    printGesture(g);
+    collar.handleGesture(g, ctx.nowMs);
+  }
+  return collar.pendingGestures();
+}
 
-    // phase 2: "cop lights" split 4+4 alternating red/blue
-    if (nowMs - lastTickMs < Config::DangerCopStepMs) {
-      return;
+// Leader: send a beacon when one is due (interval or mode change).
+// Follower: decode beacons from Serial1 and follow them.
+static bool runSyncTask(const Sched::TaskContext &ctx) {
+  if (kSyncLeader) {
+    if (syncLeader.due(ctx.nowMs, ring.mode()) && Serial1.availableForWrite() >= Sync::kFrameBytes) {
+      uint8_t frame[Sync::kFrameBytes];
+      Sync::encode(syncLeader.makeBeacon(ctx.nowMs, ring), frame);
+      Serial1.write(frame, sizeof(frame));
     }
-    lastTickMs = nowMs;
+    return false;
+  }
 
-    const bool swap = (step % 2) == 1;
-    for (uint16_t i = 0; i < PIXEL_COUNT; i++) {
-      const bool firstHalf = i < (PIXEL_COUNT / 2);
-      const uint32_t c = (firstHalf ^ swap) ? red : blue;
-      strip.setPixelColor(i, c);
+  while (Serial1.available() && !ctx.expired()) {
+    Sync::Beacon beacon{};
+    if (!syncParser.push((uint8_t)Serial1.read(), beacon)) {
+      continue;
     }
-    show();
-
-    step++;
-    if (step >= Config::DangerCopSteps) {
-      phase = 0;
-      step = 0;
-      lastTickMs = nowMs;
+    const LedMode before = ring.mode();
+    if (syncFollower.onBeacon(beacon, millis(), ring) && ring.mode() != before) {
+      collar.recordMode(ring.mode(), Flight::Source::Sync, millis());
     }
   }
-
-  
-};
-
-static LedRingController ring(strip);
-
-static const __FlashStringHelper *modeName(LedMode m) {
-  switch (m) {
-    case LedMode::Idle:
-      return F("Idle");
-    case LedMode::Peace:
-      return F("Peace");
-    case LedMode::Warning:
-      return F("Warning");
-    case LedMode::Danger:
-      return F("Danger");
-    case LedMode::SolidGreen:
-      return F("SolidGreen");
-    case LedMode::SolidYellow:
-      return F("SolidYellow");
-    case LedMode::SolidRed:
-      return F("SolidRed");
-    default:
-      return F("Unknown");
-  }
+  return Serial1.available() > 0;
 }
 
-static void printSerialHelp() {
-  Log::line(Log::Level::Info, F("Serial commands:"));
-  Log::line(Log::Level::Info, F("  1 = Idle"));
-  Log::line(Log::Level::Info, F("  2 = Peace"));
-  Log::line(Log::Level::Info, F("  3 = Warning"));
-  Log::line(Log::Level::Info, F("  4 = Danger"));
-  Log::line(Log::Level::Info, F("  h or ? = this help"));
+static bool runSerialTask(const Sched::TaskContext &ctx) {
+  while (Serial.available() && !ctx.expired()) {
+    pollSerialForModeChange();
+  }
+  return Serial.available() > 0;
 }
 
-static void printStartupBanner() {
-  Log::line(Log::Level::Info, F("TameCollar firmware boot"));
-  Log::line(Log::Level::Info, F("Source: https://github.com/zebadrabbit/TameCollar"));
-  Log::keyValue(Log::Level::Info, F("Serial baud"), Config::SerialBaud);
-
-  Log::line(Log::Level::Info, F("What you'll see in Serial output:"));
-  Log::line(Log::Level::Info, F("  - Boot banner + pin/config summary"));
-  Log::line(Log::Level::Info, F("  - RADIO: remote input transitions (HIGH/LOW)"));
-  Log::line(Log::Level::Info, F("  - MODE: changes (via remote or serial)"));
-  if (Config::SerialHeartbeatMs != 0) {
-    Log::line(Log::Level::Info, F("  - HEARTBEAT: periodic status line"));
+// Sample Vcc (its own task, so the conversion never overlaps a show()) and
+// move the ring to the matching power policy when the tier changes.
+static bool runBatteryTask(const Sched::TaskContext &ctx) {
+  if (!collar.addBatterySample(Battery::readBandgap(), ctx.nowMs)) {
+    return false;
   }
+  const Battery::Monitor &battery = collar.battery();
 
-  Log::line(Log::Level::Info, F("Hardware defaults:"));
   Log::printPrefix(Log::Level::Info);
-  Serial.print(F("  NeoPixel pin="));
-  Serial.print(NEOPIXEL_PIN);
-  Serial.print(F(", pixels="));
-  Serial.print(PIXEL_COUNT);
-  Serial.print(F(", brightness="));
-  Serial.println(STRIP_BRIGHTNESS);
-
-  Log::line(Log::Level::Info, F("Remote inputs use INPUT_PULLUP (pressed = LOW)."));
-  printSerialHelp();
+  Log::out.print(F("BATTERY: "));
+  Log::out.print(batteryTierName(battery.tier()));
+  Log::out.print(F(" at "));
+  Log::out.print(battery.mv());
+  Log::out.println(F("mV"));
+  return false;
 }
 
-static void printMode(LedMode m) {
+static bool runHeartbeatTask(const Sched::TaskContext &ctx) {
+  (void)ctx;
   Log::printPrefix(Log::Level::Info);
-  Serial.print(F("MODE: "));
-  Serial.println(modeName(m));
+  Log::out.print(F("HEARTBEAT: mode="));
+  Log::out.println(modeName(ring.mode()));
+  return false;
 }
 
-static void pollSerialForModeChange() {
-  if (!Serial.available()) {
-    return;
-  }
-
-  const char c = (char)Serial.read();
-  if (c == 'h' || c == 'H' || c == '?') {
-    printSerialHelp();
-    return;
-  }
-
-  if (c == '1') {
-    ring.setMode(LedMode::Idle);
-    printMode(LedMode::Idle);
-  } else if (c == '2') {
-    ring.setMode(LedMode::Peace);
-    printMode(LedMode::Peace);
-  } else if (c == '3') {
-    ring.setMode(LedMode::Warning);
-    printMode(LedMode::Warning);
-  } else if (c == '4') {
-    ring.setMode(LedMode::Danger);
-    printMode(LedMode::Danger);
-  } else if (c != '\n' && c != '\r') {
-    Log::printPrefix(Log::Level::Warn);
-    Serial.print(F("Unknown command: '"));
-    Serial.print(c);
-    Serial.println(F("' (send 'h' for help)"));
+static bool runLogTask(const Sched::TaskContext &ctx) {
+  while (Log::out.pending() != 0 && !ctx.expired()) {
+    const uint16_t before = Log::out.pending();
+    Log::out.drain(Log::out.pending());
+    if (Log::out.pending() == before) {
+      break; // port is full; try again next period
+    }
   }
+  return false;
 }
 
-static LedMode modeStepUpForRemote(LedMode m) {
-  // Per request: Idle -> Peace -> Warning -> Danger (clamp at Danger).
-  switch (m) {
-    case LedMode::Idle:
-      return LedMode::Peace;
-    case LedMode::Peace:
-      return LedMode::Warning;
-    case LedMode::Warning:
-      return LedMode::Danger;
-    case LedMode::Danger:
-    default:
-      return LedMode::Danger;
+static bool runReportTask(const Sched::TaskContext &ctx) {
+  while (activeReport != Report::None && Log::out.room() >= Config::LogLineMaxBytes && !ctx.expired()) {
+    if (activeReport == Report::Flight && !eeprom_is_ready()) {
+      break; // a checkpoint byte is still being written
+    }
+    bool printed = false;
+    switch (activeReport) {
+      case Report::Help:
+        printed = printSerialHelpLine(reportLine);
+        break;
+      case Report::TaskStats:
+        printed = printTaskStatsLine(reportLine);
+        break;
+      default:
+        printed = printFlightLine(reportLine);
+        break;
+    }
+    reportLine++;
+    if (!printed) {
+      activeReport = Report::None;
+    }
   }
+  return false;
 }
 
-static LedMode modeStepDownForRemote(LedMode m) {
-  // Danger -> Warning -> Peace -> Idle (clamp at Idle).
-  switch (m) {
-    case LedMode::Danger:
-      return LedMode::Warning;
-    case LedMode::Warning:
-      return LedMode::Peace;
-    case LedMode::Peace:
-    case LedMode::Idle:
-    default:
-      return LedMode::Idle;
-  }
-}
+// Checkpoint the flight recorder to EEPROM, at most every FlightCheckpointMs
+// and only if something was recorded since the last one. Paused while a dump
+// is reading the EEPROM.
+static uint32_t lastFlightCheckpointMs = 0;
 
-static LedMode modeStepUpSolidForRemote(LedMode m) {
-  // Idle -> SolidGreen -> SolidYellow -> SolidRed (clamp at SolidRed).
-  switch (m) {
-    case LedMode::Idle:
-      return LedMode::SolidGreen;
-    case LedMode::SolidGreen:
-      return LedMode::SolidYellow;
-    case LedMode::SolidYellow:
-      return LedMode::SolidRed;
-    case LedMode::SolidRed:
-      return LedMode::SolidRed;
-    default:
-      // If currently in an animated mode, start solid sequence at green.
-      return LedMode::SolidGreen;
+static bool runFlightTask(const Sched::TaskContext &ctx) {
+  if (activeReport == Report::Flight) {
+    return false;
   }
-}
-
-static LedMode modeStepDownSolidForRemote(LedMode m) {
-  // SolidRed -> SolidYellow -> SolidGreen -> Idle (clamp at Idle).
-  switch (m) {
-    case LedMode::SolidRed:
-      return LedMode::SolidYellow;
-    case LedMode::SolidYellow:
-      return LedMode::SolidGreen;
-    case LedMode::SolidGreen:
-      return LedMode::Idle;
-    case LedMode::Idle:
-      return LedMode::Idle;
-    default:
-      // If currently in an animated mode, pressing "down" goes to Idle/off.
-      return LedMode::Idle;
+  if (!flightStore.busy()) {
+    if (!flight.hasNewEvents() || ctx.nowMs - lastFlightCheckpointMs < Config::FlightCheckpointMs) {
+      return false;
+    }
+    flightStore.start(flight);
+    flight.markCheckpointed();
+    lastFlightCheckpointMs = ctx.nowMs;
   }
+  // Unchanged bytes are skipped without a write, so several may go per run.
+  while (!ctx.expired() && flightStore.step(flight)) {
+  }
+  return false;
 }
 
 void setup() {  
+  flight.record(Flight::Event::Boot, Flight::takeResetFlags(), millis());
+  flightStore.begin();
+
   Serial.begin(Config::SerialBaud);
 
 #if defined(USBCON)
@@ -941,72 +810,26 @@ void setup() {
   }
 #endif
 
+  if (kSyncEnabled) {
+    Serial1.begin(Config::SyncBaud);
+  }
+
   initRemotePins();
+  if (Config::BatteryAdaptive) {
+    Battery::begin();
+  }
   ring.begin();
   ring.setMode(LedMode::Idle);
 
   printStartupBanner();
   printMode(LedMode::Idle);
+
+  // From here on, log output must never stall the loop.
+  Log::out.drain(Log::out.pending());
+  Log::out.setBlocking(false);
+  scheduler.begin(millis());
 }
 
 void loop() {
-  pollSerialForModeChange();
-  pollRemotePinsForChanges();
-
-  if (Config::SerialHeartbeatMs != 0) {
-    static uint32_t lastHeartbeatMs = 0;
-    const uint32_t nowMs = millis();
-    if (nowMs - lastHeartbeatMs >= Config::SerialHeartbeatMs) {
-      lastHeartbeatMs = nowMs;
-      Log::printPrefix(Log::Level::Info);
-      Serial.print(F("HEARTBEAT: mode="));
-      Serial.println(modeName(ring.mode()));
-    }
-  }
-
-  const uint8_t events = remotePressEvents;
-  if (events != 0) {
-    remotePressEvents = 0;
-
-    Log::printPrefix(Log::Level::Info);
-    Serial.print(F("RADIO: press events mask=0b"));
-    for (int8_t i = (int8_t)REMOTE_PIN_COUNT - 1; i >= 0; i--) {
-      Serial.print((events & (1u << i)) ? '1' : '0');
-    }
-    Serial.println();
-
-    // Solid color modes
-    if (events & (1u << Config::RemoteIndexSolidUp)) {
-      const LedMode next = modeStepUpSolidForRemote(ring.mode());
-      ring.setMode(next);
-      printMode(next);
-    }
-
-    if (events & (1u << Config::RemoteIndexSolidDown)) {
-      const LedMode next = modeStepDownSolidForRemote(ring.mode());
-      ring.setMode(next, next == LedMode::Idle);
-      printMode(next);
-    }
-
-    // Animated modes
-    if (events & (1u << Config::RemoteIndexAnimUp)) {
-      const LedMode next = modeStepUpForRemote(ring.mode());
-      ring.setMode(next);
-      printMode(next);
-    }
-
-    if (events & (1u << Config::RemoteIndexAnimDown)) {
-      const LedMode current = ring.mode();
-      if (current == LedMode::Idle) {
-        ring.setMode(LedMode::Idle, true);
-        printMode(LedMode::Idle);
-      } else {
-        const LedMode next = modeStepDownForRemote(current);
-        ring.setMode(next);
-        printMode(next);
-      }
-    }
-  }
-
-  ring.update(millis());
-}
\ No newline at end of file
+  scheduler.runOnce(millis());
+}